@@ -0,0 +1,174 @@
+#include "lib/allocation_stats.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace proc36 {
+
+namespace {
+
+// One row per thread, written only by its owner. Everything is constant-initialised, so counting never allocates.
+struct ThreadSlot {
+    std::array<std::atomic<std::uint64_t>, kAllocationPhaseCount> allocations{};
+    std::array<std::atomic<std::uint64_t>, kAllocationPhaseCount> bytes{};
+    std::array<std::atomic<std::uint64_t>, kAllocationPhaseCount> frees{};
+};
+
+thread_local AllocationPhase current_phase = AllocationPhase::Other;
+
+#ifdef PROC36_ALLOC_TRACKING
+ThreadSlot slots[kMaxTrackedThreads];
+std::atomic<std::size_t> slots_taken{0};
+thread_local ThreadSlot* own_slot = nullptr;
+
+ThreadSlot& local_slot() noexcept {
+    if (own_slot == nullptr) {
+        const auto index = slots_taken.fetch_add(1, std::memory_order_relaxed);
+        own_slot = &slots[index < kMaxTrackedThreads ? index : kMaxTrackedThreads - 1];
+    }
+    return *own_slot;
+}
+
+std::size_t phase_index() noexcept {
+    return static_cast<std::size_t>(current_phase);
+}
+
+void record_allocation(std::size_t size) noexcept {
+    auto& slot = local_slot();
+    const auto phase = phase_index();
+    slot.allocations[phase].fetch_add(1, std::memory_order_relaxed);
+    slot.bytes[phase].fetch_add(size, std::memory_order_relaxed);
+}
+
+void record_free() noexcept {
+    local_slot().frees[phase_index()].fetch_add(1, std::memory_order_relaxed);
+}
+
+void* allocate(std::size_t size) {
+    record_allocation(size);
+    if (void* p = std::malloc(size == 0 ? 1 : size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* allocate(std::size_t size, std::align_val_t alignment) {
+    record_allocation(size);
+    const auto align = static_cast<std::size_t>(alignment);
+    const auto rounded = (size == 0 ? align : (size + align - 1) / align * align);  // aligned_alloc wants a multiple
+    if (void* p = std::aligned_alloc(align, rounded)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+#endif
+
+}  // namespace
+
+const char* to_string(AllocationPhase phase) noexcept {
+    switch (phase) {
+        case AllocationPhase::Other:
+            return "other";
+        case AllocationPhase::Search:
+            return "search";
+        case AllocationPhase::Shake:
+            return "shake";
+        case AllocationPhase::Refinement:
+            return "refinement";
+        case AllocationPhase::Shortening:
+            return "shortening";
+    }
+    return "unknown";
+}
+
+bool allocation_tracking_enabled() noexcept {
+#ifdef PROC36_ALLOC_TRACKING
+    return true;
+#else
+    return false;
+#endif
+}
+
+std::vector<ThreadAllocations> allocation_snapshot() {
+    std::vector<ThreadAllocations> threads;
+#ifdef PROC36_ALLOC_TRACKING
+    const auto count = std::min(slots_taken.load(std::memory_order_relaxed), kMaxTrackedThreads);
+    threads.reserve(count);
+    for (std::size_t index = 0; index < count; ++index) {
+        ThreadAllocations row;
+        row.thread = index;
+        for (std::size_t phase = 0; phase < kAllocationPhaseCount; ++phase) {
+            row.phases[phase].allocations = slots[index].allocations[phase].load(std::memory_order_relaxed);
+            row.phases[phase].bytes = slots[index].bytes[phase].load(std::memory_order_relaxed);
+            row.phases[phase].frees = slots[index].frees[phase].load(std::memory_order_relaxed);
+        }
+        threads.push_back(row);
+    }
+#endif
+    return threads;
+}
+
+void reset_allocation_counts() noexcept {
+#ifdef PROC36_ALLOC_TRACKING
+    for (auto& slot : slots) {
+        for (std::size_t phase = 0; phase < kAllocationPhaseCount; ++phase) {
+            slot.allocations[phase].store(0, std::memory_order_relaxed);
+            slot.bytes[phase].store(0, std::memory_order_relaxed);
+            slot.frees[phase].store(0, std::memory_order_relaxed);
+        }
+    }
+#endif
+}
+
+AllocationPhase current_allocation_phase() noexcept {
+    return current_phase;
+}
+
+void set_allocation_phase(AllocationPhase phase) noexcept {
+    current_phase = phase;
+}
+
+AllocationPhaseScope::AllocationPhaseScope(AllocationPhase phase) noexcept : previous_(current_phase) {
+    current_phase = phase;
+}
+
+AllocationPhaseScope::~AllocationPhaseScope() {
+    current_phase = previous_;
+}
+
+}  // namespace proc36
+
+#ifdef PROC36_ALLOC_TRACKING
+// The array and nothrow forms forward to these by default, so these see every allocation.
+void* operator new(std::size_t size) {
+    return proc36::allocate(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    return proc36::allocate(size, alignment);
+}
+
+void operator delete(void* p) noexcept {
+    if (p != nullptr) {
+        proc36::record_free();
+        std::free(p);
+    }
+}
+
+void operator delete(void* p, std::align_val_t) noexcept {
+    if (p != nullptr) {
+        proc36::record_free();
+        std::free(p);
+    }
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    ::operator delete(p);
+}
+
+void operator delete(void* p, std::size_t, std::align_val_t alignment) noexcept {
+    ::operator delete(p, alignment);
+}
+#endif
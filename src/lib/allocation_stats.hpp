@@ -0,0 +1,55 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace proc36 {
+
+enum class AllocationPhase { Other, Search, Shake, Refinement, Shortening };
+
+inline constexpr std::size_t kAllocationPhaseCount = 5;
+inline constexpr std::size_t kMaxTrackedThreads = 64;
+
+[[nodiscard]] const char* to_string(AllocationPhase phase) noexcept;
+
+struct AllocationCounts {
+    std::uint64_t allocations = 0;
+    std::uint64_t bytes = 0;  // requested by those allocations
+    std::uint64_t frees = 0;
+};
+
+struct ThreadAllocations {
+    std::size_t thread = 0;  // in order of each thread's first allocation
+    std::array<AllocationCounts, kAllocationPhaseCount> phases{};
+};
+
+// Whether the build replaces the global operator new and delete to count heap allocations (CMake option
+// PROC36_ALLOC_TRACKING). Without it the counts stay empty and the phase scopes only set a variable.
+[[nodiscard]] bool allocation_tracking_enabled() noexcept;
+
+// Counts of every thread that allocated since the start or the last reset. The first kMaxTrackedThreads - 1 threads
+// get a row each; later ones share the last.
+[[nodiscard]] std::vector<ThreadAllocations> allocation_snapshot();
+void reset_allocation_counts() noexcept;
+
+// Phase the calling thread's allocations are attributed to. Every thread starts in Other; thread pool tasks run in
+// the phase of the thread that queued them, so concurrent solves (orientations, regions) each keep their own.
+[[nodiscard]] AllocationPhase current_allocation_phase() noexcept;
+void set_allocation_phase(AllocationPhase phase) noexcept;
+
+// Attributes allocations on the calling thread to `phase` until destroyed, then restores the previous phase. Not for
+// coroutine frames: a scope alive across a suspension would leak its phase into whichever thread resumes next.
+class AllocationPhaseScope {
+public:
+    explicit AllocationPhaseScope(AllocationPhase phase) noexcept;
+    ~AllocationPhaseScope();
+    AllocationPhaseScope(const AllocationPhaseScope&) = delete;
+    AllocationPhaseScope& operator=(const AllocationPhaseScope&) = delete;
+
+private:
+    AllocationPhase previous_;
+};
+
+}  // namespace proc36
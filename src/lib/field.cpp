@@ -7,15 +7,39 @@
 #include <stdexcept>
 #include <vector>
 
+#include "lib/random.hpp"
+#include "lib/rotation_reach.hpp"
+
 namespace proc36 {
 
 namespace {
-[[nodiscard]] std::uint64_t splitmix64(std::uint64_t x) {
-    x += 0x9e3779b97f4a7c15ull;
-    x = (x ^ (x >> 30U)) * 0xbf58476d1ce4e5b9ull;
-    x = (x ^ (x >> 27U)) * 0x94d049bb133111ebull;
-    x = x ^ (x >> 31U);
-    return x;
+constexpr std::size_t kTiledRotationThreshold = 12;  // window size from which apply() switches to tiles
+constexpr std::size_t kRotationTile = 8;
+constexpr auto kNoCell = std::numeric_limits<std::uint32_t>::max();
+constexpr std::uint32_t kCoordBits = 16;  // tracked positions pack x in the low half and y in the high half
+constexpr std::uint32_t kCoordMask = (1U << kCoordBits) - 1;
+
+std::uint32_t pack_cell(std::size_t x, std::size_t y) noexcept {
+    return static_cast<std::uint32_t>(y << kCoordBits | x);
+}
+
+std::uint64_t cell_key(int value, std::size_t idx) noexcept {
+    return splitmix64(static_cast<std::uint64_t>(value) * 1'000'003ULL + idx);
+}
+
+// Index that cell (x, y) lands on when an n x n board is turned clockwise `quarter_turns` times.
+std::size_t turned_index(std::size_t x, std::size_t y, std::size_t n, std::size_t quarter_turns) noexcept {
+    const auto last = n - 1;
+    switch (quarter_turns % 4) {
+        case 1:
+            return x * n + (last - y);
+        case 2:
+            return (last - y) * n + (last - x);
+        case 3:
+            return (last - x) * n + y;
+        default:
+            return y * n + x;
+    }
 }
 }  // namespace
 
@@ -27,6 +51,9 @@ Field::Field(std::size_t size, std::vector<int> cells)
     if (cells_.size() != size_ * size_) {
         throw std::invalid_argument("Field cells size mismatch");
     }
+    for (std::size_t idx = 0; idx < cells_.size(); ++idx) {
+        hash_ ^= cell_key(cells_[idx], idx);
+    }
 }
 
 int Field::at(std::size_t x, std::size_t y) const {
@@ -40,7 +67,18 @@ void Field::set(std::size_t x, std::size_t y, int value) {
     if (!in_bounds(x, y)) {
         throw std::out_of_range("Field::set: position out of bounds");
     }
-    cells_[y * size_ + x] = value;
+    const auto idx = y * size_ + x;
+    hash_ ^= cell_key(cells_[idx], idx) ^ cell_key(value, idx);
+    if (rotated_tracked_) {
+        for (std::size_t turns = 1; turns < 4; ++turns) {
+            const auto to = turned_index(x, y, size_, turns);
+            rotated_hashes_[turns - 1] ^= cell_key(cells_[idx], to) ^ cell_key(value, to);
+        }
+    }
+    cells_[idx] = value;
+    if (reach_ != nullptr) {
+        rebuild_pair_positions();
+    }
 }
 
 bool Field::in_bounds(std::size_t x, std::size_t y) const noexcept {
@@ -55,24 +93,86 @@ void Field::apply(const Operation& op) {
     if (!is_valid_operation(op)) {
         throw std::invalid_argument("Invalid rotation operation");
     }
+    if (reach_ != nullptr) {
+        move_pair_positions(op);
+    }
     const auto k = op.size;
-    std::vector<int> original(k * k);
+    thread_local std::vector<int> original;
+    original.resize(k * k);
+    int* const base = cells_.data() + op.y * size_ + op.x;
     for (std::size_t dy = 0; dy < k; ++dy) {
-        for (std::size_t dx = 0; dx < k; ++dx) {
-            original[dy * k + dx] = at(op.x + dx, op.y + dy);
-        }
+        std::copy_n(base + dy * size_, k, original.data() + dy * k);
     }
 
+    // Swaps the key of every window cell whose value changes, so the hash never needs a board scan.
+    const auto first = op.y * size_ + op.x;
     for (std::size_t dy = 0; dy < k; ++dy) {
         for (std::size_t dx = 0; dx < k; ++dx) {
-            const std::size_t src_row = k - 1 - dx;
-            const std::size_t src_col = dy;
-            const auto value = original[src_row * k + src_col];
-            set(op.x + dx, op.y + dy, value);
+            const auto before = original[dy * k + dx];
+            const auto after = original[(k - 1 - dx) * k + dy];
+            if (before != after) {
+                const auto idx = first + dy * size_ + dx;
+                hash_ ^= cell_key(before, idx) ^ cell_key(after, idx);
+                if (rotated_tracked_) {
+                    for (std::size_t turns = 1; turns < 4; ++turns) {
+                        const auto to = turned_index(op.x + dx, op.y + dy, size_, turns);
+                        rotated_hashes_[turns - 1] ^= cell_key(before, to) ^ cell_key(after, to);
+                    }
+                }
+            }
+        }
+    }
+
+    if (k < kTiledRotationThreshold) {
+        for (std::size_t dy = 0; dy < k; ++dy) {
+            int* const row = base + dy * size_;
+            for (std::size_t dx = 0; dx < k; ++dx) {
+                row[dx] = original[(k - 1 - dx) * k + dy];
+            }
+        }
+        return;
+    }
+
+    // Large windows: a destination row gathers a source column, so walk the window in square tiles to keep
+    // both the rows written and the columns read resident in cache.
+    for (std::size_t ty = 0; ty < k; ty += kRotationTile) {
+        const auto ty_end = std::min(k, ty + kRotationTile);
+        for (std::size_t tx = 0; tx < k; tx += kRotationTile) {
+            const auto tx_end = std::min(k, tx + kRotationTile);
+            for (std::size_t dy = ty; dy < ty_end; ++dy) {
+                int* const row = base + dy * size_;
+                for (std::size_t dx = tx; dx < tx_end; ++dx) {
+                    row[dx] = original[(k - 1 - dx) * k + dy];
+                }
+            }
         }
     }
 }
 
+void Field::track_rotated_hashes() {
+    for (std::size_t turns = 1; turns < 4; ++turns) {
+        rotated_hashes_[turns - 1] = rotated_hash(turns);
+    }
+    rotated_tracked_ = true;
+}
+
+std::uint64_t Field::rotated_hash(std::size_t quarter_turns) const {
+    quarter_turns %= 4;
+    if (quarter_turns == 0) {
+        return hash_;
+    }
+    if (rotated_tracked_) {
+        return rotated_hashes_[quarter_turns - 1];
+    }
+    std::uint64_t hash = 0;
+    for (std::size_t y = 0; y < size_; ++y) {
+        for (std::size_t x = 0; x < size_; ++x) {
+            hash ^= cell_key(cells_[y * size_ + x], turned_index(x, y, size_, quarter_turns));
+        }
+    }
+    return hash;
+}
+
 Field Field::applied(const Operation& op) const {
     Field next = *this;
     next.apply(op);
@@ -97,8 +197,14 @@ PairStatus Field::evaluate_pairs() const {
 }
 
 PairMetrics Field::evaluate_pair_metrics() const {
+    return evaluate_pair_metrics(Rect{0, 0, size_, size_});
+}
+
+PairMetrics Field::evaluate_pair_metrics(const Rect& active) const {
     PairMetrics metrics;
+    metrics.active = active;
     metrics.unmatched_mask.assign(cells_.size(), 0);
+    metrics.status.matched = (cells_.size() - active.width * active.height) / 2;
 
     const auto initial_pairs = cells_.size() / 2;
     const Position sentinel{size_, size_};
@@ -113,56 +219,184 @@ PairMetrics Field::evaluate_pair_metrics() const {
         }
     };
 
-    for (std::size_t idx = 0; idx < cells_.size(); ++idx) {
-        const auto value = cells_[idx];
-        if (value < 0) {
-            continue;  // ignore invalid negatives defensively
-        }
-        const auto uvalue = static_cast<std::size_t>(value);
-        ensure_capacity(uvalue);
-
-        if (first_indices[uvalue] == std::numeric_limits<std::size_t>::max()) {
-            const auto x = idx % size_;
-            const auto y = idx / size_;
-            first_positions[uvalue] = Position{x, y};
-            first_indices[uvalue] = idx;
-            continue;
-        }
+    for (std::size_t y = active.y; y < active.y + active.height; ++y) {
+        for (std::size_t x = active.x; x < active.x + active.width; ++x) {
+            const auto idx = y * size_ + x;
+            const auto value = cells_[idx];
+            if (value < 0) {
+                continue;  // ignore invalid negatives defensively
+            }
+            const auto uvalue = static_cast<std::size_t>(value);
+            ensure_capacity(uvalue);
+
+            if (first_indices[uvalue] == std::numeric_limits<std::size_t>::max()) {
+                first_positions[uvalue] = Position{x, y};
+                first_indices[uvalue] = idx;
+                continue;
+            }
 
-        const auto first_index = first_indices[uvalue];
-        const auto first_pos = first_positions[uvalue];
-        const auto x = idx % size_;
-        const auto y = idx / size_;
-        const auto distance = static_cast<std::size_t>(
-            std::abs(static_cast<int>(first_pos.x) - static_cast<int>(x)) +
-            std::abs(static_cast<int>(first_pos.y) - static_cast<int>(y)));
-
-        if (distance == 1) {
-            ++metrics.status.matched;
-        } else {
-            ++metrics.status.unmatched;
-            metrics.total_unmatched_distance += distance;
-            metrics.max_unmatched_distance = std::max(metrics.max_unmatched_distance, distance);
-            metrics.unmatched_mask[first_index] = 1;
-            metrics.unmatched_mask[idx] = 1;
+            const auto first_index = first_indices[uvalue];
+            const auto first_pos = first_positions[uvalue];
+            const auto distance = static_cast<std::size_t>(
+                std::abs(static_cast<int>(first_pos.x) - static_cast<int>(x)) +
+                std::abs(static_cast<int>(first_pos.y) - static_cast<int>(y)));
+
+            if (distance == 1) {
+                ++metrics.status.matched;
+            } else {
+                ++metrics.status.unmatched;
+                metrics.total_unmatched_distance += distance;
+                metrics.max_unmatched_distance = std::max(metrics.max_unmatched_distance, distance);
+                metrics.unmatched_mask[first_index] = 1;
+                metrics.unmatched_mask[idx] = 1;
+            }
         }
     }
 
+    metrics.one_rotation_pairs = one_rotation_pairs_;
     return metrics;
 }
 
-bool Field::is_goal_state() const {
-    const auto status = evaluate_pairs();
-    return status.unmatched == 0 && status.matched * 2 == size_ * size_;
+Rect Field::shrink_active(Rect active) const {
+    // Whether every cell of the strip has its partner next to it inside the strip.
+    const auto closed = [this](const Rect& strip) {
+        for (std::size_t y = strip.y; y < strip.y + strip.height; ++y) {
+            for (std::size_t x = strip.x; x < strip.x + strip.width; ++x) {
+                const auto value = cells_[y * size_ + x];
+                const bool paired = (x > strip.x && cells_[y * size_ + x - 1] == value) ||
+                                    (x + 1 < strip.x + strip.width && cells_[y * size_ + x + 1] == value) ||
+                                    (y > strip.y && cells_[(y - 1) * size_ + x] == value) ||
+                                    (y + 1 < strip.y + strip.height && cells_[(y + 1) * size_ + x] == value);
+                if (!paired) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    };
+    bool peeled = true;
+    while (peeled && !active.empty()) {
+        peeled = false;
+        for (std::size_t thickness = 1; thickness <= 2 && !peeled; ++thickness) {
+            if (active.height >= thickness + 2) {  // keeps room for a 2x2 window
+                if (closed(Rect{active.x, active.y, active.width, thickness})) {
+                    active.y += thickness;
+                    active.height -= thickness;
+                    peeled = true;
+                } else if (closed(Rect{active.x, active.y + active.height - thickness, active.width, thickness})) {
+                    active.height -= thickness;
+                    peeled = true;
+                }
+            }
+            if (!peeled && active.width >= thickness + 2) {
+                if (closed(Rect{active.x, active.y, thickness, active.height})) {
+                    active.x += thickness;
+                    active.width -= thickness;
+                    peeled = true;
+                } else if (closed(Rect{active.x + active.width - thickness, active.y, thickness, active.height})) {
+                    active.width -= thickness;
+                    peeled = true;
+                }
+            }
+        }
+    }
+    return active;
 }
 
-std::uint64_t Field::zobrist_hash() const {
-    std::uint64_t hash = 0;
+void Field::track_one_rotation_pairs(const RotationReach* reach) {
+    if (reach != nullptr && reach->board_size() != size_) {
+        throw std::invalid_argument("RotationReach board size mismatch");
+    }
+    reach_ = reach;
+    pair_positions_.clear();
+    one_rotation_pairs_ = 0;
+    if (reach_ != nullptr) {
+        rebuild_pair_positions();
+    }
+}
+
+bool Field::one_rotation_pair(std::uint32_t a, std::uint32_t b) const noexcept {
+    if (a == kNoCell || b == kNoCell) {
+        return false;
+    }
+    const auto ax = a & kCoordMask;
+    const auto ay = a >> kCoordBits;
+    const auto bx = b & kCoordMask;
+    const auto by = b >> kCoordBits;
+    const auto distance = (ax > bx ? ax - bx : bx - ax) + (ay > by ? ay - by : by - ay);
+    return (distance != 1) & reach_->completes(ay * size_ + ax, by * size_ + bx);  // & keeps it branch-free
+}
+
+void Field::rebuild_pair_positions() {
+    pair_positions_.assign(cells_.size(), kNoCell);
     for (std::size_t idx = 0; idx < cells_.size(); ++idx) {
-        const auto mixed = splitmix64(static_cast<std::uint64_t>(cells_[idx]) * 1'000'003ULL + idx);
-        hash ^= mixed + 0x9e3779b97f4a7c15ULL + (hash << 6U) + (hash >> 2U);
+        const auto value = static_cast<std::size_t>(cells_[idx]);
+        if (cells_[idx] < 0 || 2 * value + 1 >= pair_positions_.size()) {
+            continue;  // not a pair value of this board
+        }
+        auto& slot = pair_positions_[2 * value];
+        (slot == kNoCell ? slot : pair_positions_[2 * value + 1]) = pack_cell(idx % size_, idx / size_);
     }
-    return hash;
+    one_rotation_pairs_ = 0;
+    for (std::size_t value = 0; 2 * value + 1 < pair_positions_.size(); ++value) {
+        if (one_rotation_pair(pair_positions_[2 * value], pair_positions_[2 * value + 1])) {
+            ++one_rotation_pairs_;
+        }
+    }
+}
+
+// Only pairs with a cell inside the window move, and whether a pair is one rotation from done depends on nothing
+// but its own two cells, so the count changes by what those pairs contribute before and after.
+void Field::move_pair_positions(const Operation& op) {
+    const auto k = op.size;
+    const auto x0 = static_cast<std::uint32_t>(op.x);
+    const auto y0 = static_cast<std::uint32_t>(op.y);
+    const auto side = static_cast<std::uint32_t>(k);
+    // New positions are written once every pair has been looked at, so a pair with both cells inside is seen
+    // unmoved from both and taken from the one that comes first in row-major order (the smaller packed position).
+    thread_local std::vector<std::pair<std::size_t, std::uint32_t>> writes;
+    writes.clear();
+    std::size_t before = 0;
+    std::size_t after = 0;
+    for (std::uint32_t dy = 0; dy < side; ++dy) {
+        const int* const row = cells_.data() + (op.y + dy) * size_ + op.x;
+        for (std::uint32_t dx = 0; dx < side; ++dx) {
+            const auto value = static_cast<std::size_t>(row[dx]);
+            if (row[dx] < 0 || 2 * value + 1 >= pair_positions_.size()) {
+                continue;
+            }
+            const auto cell = pack_cell(x0 + dx, y0 + dy);
+            const auto slot = 2 * value + (pair_positions_[2 * value] == cell ? 0 : 1);
+            const auto other = pair_positions_[slot ^ 1];
+            const auto rotated = pack_cell(x0 + side - 1 - dy, y0 + dx);
+            if (other == kNoCell) {
+                writes.emplace_back(slot, rotated);
+                continue;
+            }
+            const auto ox = (other & kCoordMask) - x0;  // wraps around when left of the window
+            const auto oy = (other >> kCoordBits) - y0;
+            const bool other_inside = ox < side && oy < side;
+            if (other_inside && other < cell) {
+                continue;  // taken from the other cell
+            }
+            const auto other_after = other_inside ? pack_cell(x0 + side - 1 - oy, y0 + ox) : other;
+            before += one_rotation_pair(cell, other);
+            after += one_rotation_pair(rotated, other_after);
+            writes.emplace_back(slot, rotated);
+            if (other_inside) {
+                writes.emplace_back(slot ^ 1, other_after);
+            }
+        }
+    }
+    for (const auto& [slot, cell] : writes) {
+        pair_positions_[slot] = cell;
+    }
+    one_rotation_pairs_ = one_rotation_pairs_ + after - before;
+}
+
+bool Field::is_goal_state() const {
+    const auto status = evaluate_pairs();
+    return status.unmatched == 0 && status.matched * 2 == size_ * size_;
 }
 
 std::string Field::to_string() const {
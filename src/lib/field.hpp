@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <cstddef>
 #include <cstdint>
 #include <string>
@@ -10,6 +11,8 @@
 
 namespace proc36 {
 
+class RotationReach;
+
 struct Position {
     std::size_t x{};
     std::size_t y{};
@@ -19,6 +22,22 @@ struct Position {
     }
 };
 
+// Axis-aligned block of cells.
+struct Rect {
+    std::size_t x{};
+    std::size_t y{};
+    std::size_t width{};
+    std::size_t height{};
+
+    [[nodiscard]] bool empty() const noexcept { return width == 0 || height == 0; }
+    [[nodiscard]] bool contains(const Position& cell) const noexcept {
+        return cell.x >= x && cell.x < x + width && cell.y >= y && cell.y < y + height;
+    }
+    [[nodiscard]] bool contains(const Operation& op) const noexcept {
+        return op.x >= x && op.y >= y && op.x + op.size <= x + width && op.y + op.size <= y + height;
+    }
+};
+
 struct PairStatus {
     std::size_t matched{};
     std::size_t unmatched{};
@@ -29,6 +48,8 @@ struct PairMetrics {
     std::size_t total_unmatched_distance{};
     std::size_t max_unmatched_distance{};
     std::vector<std::uint8_t> unmatched_mask;  // row-major mask, 1 if the cell belongs to an unmatched pair
+    std::size_t one_rotation_pairs{};  // unmatched pairs one allowed rotation would complete (tracking fields only)
+    Rect active{};  // cells the search may still rotate; empty means the whole board
 };
 
 class Field {
@@ -38,6 +59,7 @@ public:
 
     [[nodiscard]] std::size_t size() const noexcept { return size_; }
     [[nodiscard]] std::size_t cell_count() const noexcept { return cells_.size(); }
+    [[nodiscard]] const std::vector<int>& cells() const noexcept { return cells_; }  // row-major
 
     [[nodiscard]] int at(std::size_t x, std::size_t y) const;
     void set(std::size_t x, std::size_t y, int value);
@@ -51,16 +73,48 @@ public:
     [[nodiscard]] std::vector<Position> positions_of(int value) const;
     [[nodiscard]] PairStatus evaluate_pairs() const;
     [[nodiscard]] PairMetrics evaluate_pair_metrics() const;
+    // Scans only the cells inside `active`, which no pair may straddle; the cells outside count as matched pairs.
+    [[nodiscard]] PairMetrics evaluate_pair_metrics(const Rect& active) const;
+    // `active` without the edge strips (one or two cells thick) whose cells are all matched within the strip,
+    // peeled repeatedly. Such strips never need to move again, and what remains has no pair leaving it.
+    [[nodiscard]] Rect shrink_active(Rect active) const;
 
     [[nodiscard]] bool is_goal_state() const;
 
-    [[nodiscard]] std::uint64_t zobrist_hash() const;
+    // Keeps the number of unmatched pairs that one rotation allowed by `reach` would complete, maintained by apply()
+    // from a value-to-position index in O(k^2) per rotation and reported by evaluate_pair_metrics(). Null stops it.
+    // `reach` must outlive the field and every copy of it. Copies carry the index (n^2 more words), which adds about
+    // 40 ns to copying a 12x12 or 24x24 board against 1-2 us for the update in apply(), so it is not shared.
+    void track_one_rotation_pairs(const RotationReach* reach);
+    [[nodiscard]] std::size_t one_rotation_pairs() const noexcept { return one_rotation_pairs_; }
+    // Heap bytes held by the tracking index on top of the cells.
+    [[nodiscard]] std::size_t tracking_bytes() const noexcept {
+        return pair_positions_.capacity() * sizeof(std::uint32_t);
+    }
+
+    // XOR of one random key per (value, cell), kept up to date by set() and apply() in O(k^2) per rotation.
+    [[nodiscard]] std::uint64_t zobrist_hash() const noexcept { return hash_; }
+    // Keeps the Zobrist hashes of the board turned clockwise by one, two and three quarter turns up to date as well,
+    // at three more keys per changed cell, so rotated_hash() needs no scan. Copies keep tracking.
+    void track_rotated_hashes();
+    // Zobrist hash of the board turned clockwise `quarter_turns` times (mod 4); scans the board unless tracked.
+    [[nodiscard]] std::uint64_t rotated_hash(std::size_t quarter_turns) const;
 
     [[nodiscard]] std::string to_string() const;
 
 private:
+    void rebuild_pair_positions();
+    void move_pair_positions(const Operation& op);
+    [[nodiscard]] bool one_rotation_pair(std::uint32_t a, std::uint32_t b) const noexcept;
+
     std::size_t size_{};
     std::vector<int> cells_;
+    const RotationReach* reach_ = nullptr;
+    std::vector<std::uint32_t> pair_positions_;  // packed cells of value v at 2v and 2v + 1, while tracking
+    std::size_t one_rotation_pairs_ = 0;
+    std::uint64_t hash_ = 0;
+    bool rotated_tracked_ = false;
+    std::array<std::uint64_t, 3> rotated_hashes_{};  // quarter turns 1..3, while tracking
 };
 
 }  // namespace proc36
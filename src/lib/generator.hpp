@@ -0,0 +1,74 @@
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+namespace proc36 {
+
+// Minimal lazily started coroutine generator. Each next() resumes the body up to its following co_yield; an
+// exception escaping the body is rethrown from next(). Nested generators are forwarded by the caller with
+// `while (inner.next()) co_yield inner.value();`.
+template <typename T>
+class Generator {
+public:
+    struct promise_type {
+        std::optional<T> current;
+        std::exception_ptr exception;
+
+        Generator get_return_object() noexcept {
+            return Generator(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() const noexcept { return {}; }
+        std::suspend_always final_suspend() const noexcept { return {}; }
+        std::suspend_always yield_value(T value) {
+            current = std::move(value);
+            return {};
+        }
+        void return_void() const noexcept {}
+        void unhandled_exception() noexcept { exception = std::current_exception(); }
+    };
+
+    Generator() = default;
+    Generator(Generator&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+    Generator& operator=(Generator&& other) noexcept {
+        if (this != &other) {
+            reset();
+            handle_ = std::exchange(other.handle_, {});
+        }
+        return *this;
+    }
+    Generator(const Generator&) = delete;
+    Generator& operator=(const Generator&) = delete;
+    ~Generator() { reset(); }
+
+    // Runs to the next co_yield; false once the body has finished.
+    bool next() {
+        if (!handle_ || handle_.done()) {
+            return false;
+        }
+        handle_.resume();
+        if (handle_.promise().exception) {
+            std::rethrow_exception(std::exchange(handle_.promise().exception, {}));
+        }
+        return !handle_.done();
+    }
+
+    [[nodiscard]] const T& value() const { return *handle_.promise().current; }
+    [[nodiscard]] bool done() const noexcept { return !handle_ || handle_.done(); }
+
+private:
+    explicit Generator(std::coroutine_handle<promise_type> handle) noexcept : handle_(handle) {}
+
+    void reset() noexcept {
+        if (handle_) {
+            handle_.destroy();
+            handle_ = {};
+        }
+    }
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+}  // namespace proc36
@@ -0,0 +1,158 @@
+#include "lib/http.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
+
+namespace proc36 {
+
+namespace {
+
+std::string lower(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(),
+                   [](unsigned char ch) { return static_cast<char>(std::tolower(ch)); });
+    return text;
+}
+
+std::map<std::string, std::string> read_headers(Socket& socket) {
+    std::map<std::string, std::string> headers;
+    std::string line;
+    while (socket.read_line(line) && !line.empty()) {
+        const auto colon = line.find(':');
+        if (colon == std::string::npos) {
+            continue;
+        }
+        auto value = line.substr(colon + 1);
+        value.erase(0, value.find_first_not_of(" \t"));
+        headers[lower(line.substr(0, colon))] = std::move(value);
+    }
+    return headers;
+}
+
+std::string read_body(Socket& socket, const std::map<std::string, std::string>& headers, bool until_close) {
+    if (const auto it = headers.find("transfer-encoding"); it != headers.end() && lower(it->second) == "chunked") {
+        std::string body;
+        std::string line;
+        while (socket.read_line(line)) {
+            const auto size = std::stoul(line, nullptr, 16);
+            if (size == 0) {
+                socket.read_line(line);  // trailing CRLF after the last chunk
+                break;
+            }
+            body += socket.read_exact(size);
+            socket.read_line(line);
+        }
+        return body;
+    }
+    if (const auto it = headers.find("content-length"); it != headers.end()) {
+        return socket.read_exact(std::stoul(it->second));
+    }
+    return until_close ? socket.read_all() : std::string{};
+}
+
+const char* reason_phrase(int status) {
+    switch (status) {
+        case 200:
+            return "OK";
+        case 400:
+            return "Bad Request";
+        case 401:
+            return "Unauthorized";
+        case 404:
+            return "Not Found";
+        case 429:
+            return "Too Many Requests";
+        default:
+            return "Status";
+    }
+}
+
+}  // namespace
+
+HttpUrl HttpUrl::parse(const std::string& url) {
+    std::string rest = url;
+    if (const auto scheme = rest.find("://"); scheme != std::string::npos) {
+        if (rest.substr(0, scheme) != "http") {
+            throw std::runtime_error("Only http:// URLs are supported: " + url);
+        }
+        rest.erase(0, scheme + 3);
+    }
+    HttpUrl parsed;
+    const auto slash = rest.find('/');
+    if (slash != std::string::npos) {
+        parsed.path = rest.substr(slash);
+        rest.erase(slash);
+    }
+    const auto colon = rest.find(':');
+    if (colon != std::string::npos) {
+        parsed.port = static_cast<std::uint16_t>(std::stoul(rest.substr(colon + 1)));
+        rest.erase(colon);
+    }
+    if (rest.empty()) {
+        throw std::runtime_error("URL without host: " + url);
+    }
+    parsed.host = rest;
+    return parsed;
+}
+
+HttpUrl HttpUrl::with_path(std::string new_path) const {
+    HttpUrl url = *this;
+    url.path = std::move(new_path);
+    return url;
+}
+
+HttpResponse http_request(const std::string& method, const HttpUrl& url, const std::string& body,
+                          const HttpHeaders& headers, int timeout_ms) {
+    auto socket = Socket::connect_tcp(url.host, url.port, timeout_ms);
+    std::string request = method + " " + url.path + " HTTP/1.1\r\nHost: " + url.host + "\r\nConnection: close\r\n";
+    for (const auto& [name, value] : headers) {
+        request += name + ": " + value + "\r\n";
+    }
+    if (!body.empty() || method == "POST") {
+        request += "Content-Type: application/json\r\nContent-Length: " + std::to_string(body.size()) + "\r\n";
+    }
+    request += "\r\n";
+    request += body;
+    socket.send_all(request);
+
+    std::string status_line;
+    if (!socket.read_line(status_line)) {
+        throw std::runtime_error("Empty HTTP response from " + url.host);
+    }
+    const auto space = status_line.find(' ');
+    if (space == std::string::npos) {
+        throw std::runtime_error("Malformed HTTP status line: " + status_line);
+    }
+    HttpResponse response;
+    response.status = std::stoi(status_line.substr(space + 1));
+    const auto response_headers = read_headers(socket);
+    response.body = read_body(socket, response_headers, true);
+    return response;
+}
+
+bool read_http_request(Socket& socket, HttpRequest& request) {
+    std::string request_line;
+    if (!socket.read_line(request_line)) {
+        return false;
+    }
+    const auto first = request_line.find(' ');
+    const auto second = request_line.find(' ', first + 1);
+    if (first == std::string::npos) {
+        throw std::runtime_error("Malformed HTTP request line: " + request_line);
+    }
+    request.method = request_line.substr(0, first);
+    request.path = request_line.substr(first + 1, second == std::string::npos ? std::string::npos : second - first - 1);
+    request.headers = read_headers(socket);
+    request.body = read_body(socket, request.headers, false);
+    return true;
+}
+
+void write_http_response(const Socket& socket, int status, const std::string& body, const std::string& content_type) {
+    std::string response = "HTTP/1.1 " + std::to_string(status) + " " + reason_phrase(status) +
+                           "\r\nContent-Type: " + content_type + "\r\nContent-Length: " +
+                           std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n";
+    response += body;
+    socket.send_all(response);
+}
+
+}  // namespace proc36
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "lib/socket.hpp"
+
+namespace proc36 {
+
+// Just enough HTTP/1.1 for the contest server: one request per connection, Content-Length or chunked bodies.
+
+struct HttpUrl {
+    std::string host;
+    std::uint16_t port = 80;
+    std::string path = "/";
+
+    // Accepts "http://host[:port][/path]" or "host[:port][/path]".
+    static HttpUrl parse(const std::string& url);
+    [[nodiscard]] HttpUrl with_path(std::string new_path) const;
+};
+
+using HttpHeaders = std::vector<std::pair<std::string, std::string>>;
+
+struct HttpResponse {
+    int status = 0;
+    std::string body;
+};
+
+struct HttpRequest {
+    std::string method;
+    std::string path;
+    std::map<std::string, std::string> headers;  // names lower-cased
+    std::string body;
+};
+
+// Connecting, sending and each read give up after kHttpTimeoutMs so a stalled server cannot block the caller forever.
+inline constexpr int kHttpTimeoutMs = 10000;
+
+[[nodiscard]] HttpResponse http_request(const std::string& method, const HttpUrl& url, const std::string& body = {},
+                                        const HttpHeaders& headers = {}, int timeout_ms = kHttpTimeoutMs);
+
+// Server side: reads one request from an accepted connection; false if the peer closed before sending one.
+bool read_http_request(Socket& socket, HttpRequest& request);
+void write_http_response(const Socket& socket, int status, const std::string& body,
+                         const std::string& content_type = "application/json");
+
+}  // namespace proc36
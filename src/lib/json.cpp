@@ -0,0 +1,166 @@
+#include "lib/json.hpp"
+
+#include <cctype>
+#include <cstdlib>
+
+namespace proc36 {
+
+namespace {
+
+// Position just after the colon following "key", with whitespace skipped.
+std::optional<std::size_t> value_start(const std::string& json, std::string_view key) {
+    std::string quoted;
+    quoted.reserve(key.size() + 2);
+    quoted.push_back('"');
+    quoted.append(key);
+    quoted.push_back('"');
+    const auto pos = json.find(quoted);
+    if (pos == std::string::npos) {
+        return std::nullopt;
+    }
+    auto idx = json.find(':', pos + quoted.size());
+    if (idx == std::string::npos) {
+        return std::nullopt;
+    }
+    ++idx;
+    while (idx < json.size() && std::isspace(static_cast<unsigned char>(json[idx]))) {
+        ++idx;
+    }
+    return idx;
+}
+
+// UTF-8 for a \uXXXX escape; surrogate halves are kept as they are, one at a time.
+void append_utf8(std::string& out, unsigned code) {
+    if (code < 0x80) {
+        out.push_back(static_cast<char>(code));
+    } else if (code < 0x800) {
+        out.push_back(static_cast<char>(0xc0 | (code >> 6)));
+        out.push_back(static_cast<char>(0x80 | (code & 0x3f)));
+    } else {
+        out.push_back(static_cast<char>(0xe0 | (code >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3f)));
+        out.push_back(static_cast<char>(0x80 | (code & 0x3f)));
+    }
+}
+
+}  // namespace
+
+std::optional<std::string> json_string_field(const std::string& json, std::string_view key) {
+    const auto start = value_start(json, key);
+    if (!start || *start >= json.size() || json[*start] != '"') {
+        return std::nullopt;
+    }
+    std::string value;
+    for (std::size_t i = *start + 1; i < json.size(); ++i) {
+        const char ch = json[i];
+        if (ch == '"') {
+            return value;
+        }
+        if (ch == '\\' && i + 1 < json.size()) {
+            ++i;
+            const char escaped = json[i];
+            if (escaped == 'u' && i + 4 < json.size()) {
+                append_utf8(value, static_cast<unsigned>(std::strtoul(json.substr(i + 1, 4).c_str(), nullptr, 16)));
+                i += 4;
+                continue;
+            }
+            value.push_back(escaped == 'n' ? '\n' : escaped == 't' ? '\t' : escaped);
+            continue;
+        }
+        value.push_back(ch);
+    }
+    return std::nullopt;
+}
+
+std::optional<double> json_number_field(const std::string& json, std::string_view key) {
+    const auto start = value_start(json, key);
+    if (!start || *start >= json.size()) {
+        return std::nullopt;
+    }
+    const char* begin = json.c_str() + *start;
+    char* end = nullptr;
+    const double value = std::strtod(begin, &end);
+    if (end == begin) {
+        return std::nullopt;
+    }
+    return value;
+}
+
+std::optional<std::string> json_compound_field(const std::string& json, std::string_view key) {
+    const auto start = value_start(json, key);
+    if (!start || *start >= json.size()) {
+        return std::nullopt;
+    }
+    const char open = json[*start];
+    if (open != '{' && open != '[') {
+        return std::nullopt;
+    }
+    std::size_t depth = 0;
+    bool in_string = false;
+    for (std::size_t i = *start; i < json.size(); ++i) {
+        const char ch = json[i];
+        if (in_string) {
+            if (ch == '\\') {
+                ++i;
+            } else if (ch == '"') {
+                in_string = false;
+            }
+            continue;
+        }
+        if (ch == '"') {
+            in_string = true;
+        } else if (ch == '{' || ch == '[') {
+            ++depth;
+        } else if (ch == '}' || ch == ']') {
+            if (--depth == 0) {
+                return json.substr(*start, i - *start + 1);
+            }
+        }
+    }
+    return std::nullopt;
+}
+
+std::string json_escape(std::string_view text) {
+    std::string escaped;
+    escaped.reserve(text.size());
+    for (const char ch : text) {
+        switch (ch) {
+            case '"':
+                escaped += "\\\"";
+                break;
+            case '\\':
+                escaped += "\\\\";
+                break;
+            case '\n':
+                escaped += "\\n";
+                break;
+            case '\t':
+                escaped += "\\t";
+                break;
+            default:
+                if (static_cast<unsigned char>(ch) < 0x20) {
+                    constexpr char kHex[] = "0123456789abcdef";
+                    escaped += "\\u00";
+                    escaped.push_back(kHex[static_cast<unsigned char>(ch) >> 4]);
+                    escaped.push_back(kHex[static_cast<unsigned char>(ch) & 0xf]);
+                } else {
+                    escaped.push_back(ch);
+                }
+        }
+    }
+    return escaped;
+}
+
+std::string json_ops_array(const std::vector<Operation>& ops) {
+    std::string out = "[";
+    for (std::size_t i = 0; i < ops.size(); ++i) {
+        if (i != 0) {
+            out.push_back(',');
+        }
+        out += ops[i].to_string();
+    }
+    out.push_back(']');
+    return out;
+}
+
+}  // namespace proc36
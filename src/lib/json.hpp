@@ -0,0 +1,25 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "lib/operation.hpp"
+
+namespace proc36 {
+
+// Minimal helpers for the flat JSON messages exchanged by the tools. Like the problem parser they scan for the
+// first occurrence of a key rather than building a document tree.
+
+[[nodiscard]] std::optional<std::string> json_string_field(const std::string& json, std::string_view key);
+[[nodiscard]] std::optional<double> json_number_field(const std::string& json, std::string_view key);
+// Raw text of the object or array value stored under `key`, brackets included.
+[[nodiscard]] std::optional<std::string> json_compound_field(const std::string& json, std::string_view key);
+
+// Quotes, backslashes and control characters escaped (\n and \t by name, the rest as \u00XX).
+[[nodiscard]] std::string json_escape(std::string_view text);
+// Single-line form of an answer's "ops" array.
+[[nodiscard]] std::string json_ops_array(const std::vector<Operation>& ops);
+
+}  // namespace proc36
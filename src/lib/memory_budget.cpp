@@ -0,0 +1,57 @@
+#include "lib/memory_budget.hpp"
+
+namespace proc36 {
+
+namespace {
+
+void raise_to(std::atomic<std::size_t>& peak, std::size_t value) noexcept {
+    auto current = peak.load(std::memory_order_relaxed);
+    while (value > current && !peak.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+}  // namespace
+
+const char* to_string(MemoryComponent component) noexcept {
+    switch (component) {
+        case MemoryComponent::Layers:
+            return "layers";
+        case MemoryComponent::Expansion:
+            return "expansion";
+        case MemoryComponent::VisitedSet:
+            return "visited";
+    }
+    return "unknown";
+}
+
+void MemoryBudget::add(MemoryComponent component, std::size_t bytes) noexcept {
+    const auto index = static_cast<std::size_t>(component);
+    raise_to(peak_[index], used_[index].fetch_add(bytes, std::memory_order_relaxed) + bytes);
+    raise_to(total_peak_, total_.fetch_add(bytes, std::memory_order_relaxed) + bytes);
+}
+
+void MemoryBudget::release(MemoryComponent component, std::size_t bytes) noexcept {
+    used_[static_cast<std::size_t>(component)].fetch_sub(bytes, std::memory_order_relaxed);
+    total_.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+std::size_t MemoryBudget::used(MemoryComponent component) const noexcept {
+    return used_[static_cast<std::size_t>(component)].load(std::memory_order_relaxed);
+}
+
+std::size_t MemoryBudget::peak(MemoryComponent component) const noexcept {
+    return peak_[static_cast<std::size_t>(component)].load(std::memory_order_relaxed);
+}
+
+void MemoryCharge::set(std::size_t bytes) noexcept {
+    if (budget_ != nullptr) {
+        if (bytes > bytes_) {
+            budget_->add(component_, bytes - bytes_);
+        } else if (bytes < bytes_) {
+            budget_->release(component_, bytes_ - bytes);
+        }
+    }
+    bytes_ = bytes;
+}
+
+}  // namespace proc36
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace proc36 {
+
+enum class MemoryComponent { Layers, Expansion, VisitedSet };
+
+inline constexpr std::size_t kMemoryComponentCount = 3;
+
+[[nodiscard]] const char* to_string(MemoryComponent component) noexcept;
+
+// Byte accountant shared by every solve that should fit under one ceiling (e.g. all orientations of a portfolio).
+// Components report estimates of what they hold; the search asks over_budget() and degrades when it is. A limit of
+// 0 only records usage. All members are thread-safe.
+class MemoryBudget {
+public:
+    explicit MemoryBudget(std::size_t limit_bytes = 0) noexcept : limit_(limit_bytes) {}
+
+    void add(MemoryComponent component, std::size_t bytes) noexcept;
+    void release(MemoryComponent component, std::size_t bytes) noexcept;
+
+    [[nodiscard]] std::size_t limit() const noexcept { return limit_; }
+    [[nodiscard]] std::size_t used() const noexcept { return total_.load(std::memory_order_relaxed); }
+    [[nodiscard]] std::size_t used(MemoryComponent component) const noexcept;
+    [[nodiscard]] std::size_t peak() const noexcept { return total_peak_.load(std::memory_order_relaxed); }
+    [[nodiscard]] std::size_t peak(MemoryComponent component) const noexcept;
+    [[nodiscard]] bool over_budget() const noexcept { return limit_ > 0 && used() > limit_; }
+
+    // Degradation steps taken by the search, for reporting.
+    void record_eviction() noexcept { evictions_.fetch_add(1, std::memory_order_relaxed); }
+    void record_beam_shrink() noexcept { beam_shrinks_.fetch_add(1, std::memory_order_relaxed); }
+    [[nodiscard]] std::size_t evictions() const noexcept { return evictions_.load(std::memory_order_relaxed); }
+    [[nodiscard]] std::size_t beam_shrinks() const noexcept { return beam_shrinks_.load(std::memory_order_relaxed); }
+
+private:
+    std::size_t limit_;
+    std::atomic<std::size_t> total_{0};
+    std::atomic<std::size_t> total_peak_{0};
+    std::array<std::atomic<std::size_t>, kMemoryComponentCount> used_{};
+    std::array<std::atomic<std::size_t>, kMemoryComponentCount> peak_{};
+    std::atomic<std::size_t> evictions_{0};
+    std::atomic<std::size_t> beam_shrinks_{0};
+};
+
+// Holds a resizable charge against one component and returns it on destruction. A null budget makes it a no-op.
+class MemoryCharge {
+public:
+    MemoryCharge(MemoryBudget* budget, MemoryComponent component) noexcept : budget_(budget), component_(component) {}
+    ~MemoryCharge() { set(0); }
+    MemoryCharge(const MemoryCharge&) = delete;
+    MemoryCharge& operator=(const MemoryCharge&) = delete;
+
+    void set(std::size_t bytes) noexcept;
+    void add(std::size_t bytes) noexcept { set(bytes_ + bytes); }
+    [[nodiscard]] std::size_t bytes() const noexcept { return bytes_; }
+
+private:
+    MemoryBudget* budget_;
+    MemoryComponent component_;
+    std::size_t bytes_ = 0;
+};
+
+}  // namespace proc36
@@ -0,0 +1,120 @@
+#include "lib/pair_index.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace proc36 {
+
+namespace {
+
+constexpr auto kNoPartner = std::numeric_limits<std::size_t>::max();
+
+std::size_t distance(std::size_t size, std::size_t a, std::size_t b) noexcept {
+    const auto ax = a % size;
+    const auto ay = a / size;
+    const auto bx = b % size;
+    const auto by = b / size;
+    return (ax > bx ? ax - bx : bx - ax) + (ay > by ? ay - by : by - ay);
+}
+
+}  // namespace
+
+PairIndex::PairIndex(const Field& field)
+    : size_(field.size()), partner_(field.cell_count(), kNoPartner), unmatched_count_(2 * field.size(), 0) {
+    const auto& cells = field.cells();
+    std::vector<std::size_t> first;
+    for (std::size_t idx = 0; idx < cells.size(); ++idx) {
+        if (cells[idx] < 0) {
+            continue;
+        }
+        const auto value = static_cast<std::size_t>(cells[idx]);
+        if (value >= first.size()) {
+            first.resize(value + 1, kNoPartner);
+        }
+        if (first[value] == kNoPartner) {
+            first[value] = idx;
+            continue;
+        }
+        partner_[idx] = first[value];
+        partner_[first[value]] = idx;
+        const auto d = distance(size_, first[value], idx);
+        if (d == 1) {
+            ++metrics_.status.matched;
+        } else {
+            ++metrics_.status.unmatched;
+            ++unmatched_count_[d];
+            metrics_.total_unmatched_distance += d;
+            metrics_.max_unmatched_distance = std::max(metrics_.max_unmatched_distance, d);
+        }
+    }
+}
+
+PairMetrics PairIndex::metrics_after(const Operation& op, Scratch& scratch) const {
+    PairMetrics after;
+    after.status = metrics_.status;
+    after.total_unmatched_distance = metrics_.total_unmatched_distance;
+    scratch.removed.resize(unmatched_count_.size(), 0);
+    scratch.touched.clear();
+
+    const auto k = op.size;
+    const auto inside = [&](std::size_t cell) {
+        const auto x = cell % size_;
+        const auto y = cell / size_;
+        return x >= op.x && x < op.x + k && y >= op.y && y < op.y + k;
+    };
+    // Clockwise, as Field::apply: window cell (cx, cy) moves to (k - 1 - cy, cx).
+    const auto moved = [&](std::size_t cell) {
+        if (!inside(cell)) {
+            return cell;
+        }
+        const auto cx = cell % size_ - op.x;
+        const auto cy = cell / size_ - op.y;
+        return (op.y + cx) * size_ + op.x + k - 1 - cy;
+    };
+
+    std::size_t new_max = 0;
+    for (std::size_t dy = 0; dy < k; ++dy) {
+        for (std::size_t dx = 0; dx < k; ++dx) {
+            const auto cell = (op.y + dy) * size_ + op.x + dx;
+            const auto other = partner_[cell];
+            if (other == kNoPartner || (other < cell && inside(other))) {
+                continue;  // unpaired, or the pair was already counted from its other cell
+            }
+            const auto before = distance(size_, cell, other);
+            if (before == 1) {
+                --after.status.matched;
+            } else {
+                --after.status.unmatched;
+                after.total_unmatched_distance -= before;
+                if (scratch.removed[before]++ == 0) {
+                    scratch.touched.push_back(before);
+                }
+            }
+            const auto now = distance(size_, moved(cell), moved(other));
+            if (now == 1) {
+                ++after.status.matched;
+            } else {
+                ++after.status.unmatched;
+                after.total_unmatched_distance += now;
+                new_max = std::max(new_max, now);
+            }
+        }
+    }
+
+    // Largest distance among the unmatched pairs the rotation left alone.
+    std::size_t kept_max = 0;
+    for (auto d = metrics_.max_unmatched_distance; d > 1; --d) {
+        if (unmatched_count_[d] > scratch.removed[d]) {
+            kept_max = d;
+            break;
+        }
+    }
+    after.max_unmatched_distance = std::max(kept_max, new_max);
+
+    for (const auto d : scratch.touched) {
+        scratch.removed[d] = 0;
+    }
+    return after;
+}
+
+}  // namespace proc36
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "lib/field.hpp"
+#include "lib/operation.hpp"
+
+namespace proc36 {
+
+// Partner cell of every cell plus a histogram of unmatched pair distances, so the pair metrics after one rotation
+// follow from the k^2 cells of its window instead of a full board scan and copy.
+class PairIndex {
+public:
+    // Per-thread buffers for metrics_after(); reused across calls.
+    struct Scratch {
+        std::vector<std::size_t> removed;  // unmatched pairs per distance taken out by the rotation
+        std::vector<std::size_t> touched;
+    };
+
+    explicit PairIndex(const Field& field);
+
+    // Metrics of the field as indexed; the unmatched mask is left empty.
+    [[nodiscard]] const PairMetrics& metrics() const noexcept { return metrics_; }
+    // Metrics of the field with `op` applied, without the unmatched mask. The field itself is not needed.
+    [[nodiscard]] PairMetrics metrics_after(const Operation& op, Scratch& scratch) const;
+
+private:
+    std::size_t size_;
+    std::vector<std::size_t> partner_;          // npos for cells without a partner
+    std::vector<std::size_t> unmatched_count_;  // unmatched pairs per Manhattan distance
+    PairMetrics metrics_;
+};
+
+}  // namespace proc36
@@ -1,7 +1,9 @@
 #include "lib/problem.hpp"
 
+#include <algorithm>
 #include <cctype>
 #include <fstream>
+#include <random>
 #include <sstream>
 #include <stdexcept>
 #include <string_view>
@@ -91,6 +93,43 @@ std::vector<int> parse_entities(const std::string& json, std::size_t size) {
     return values;
 }
 
+std::size_t find_matching_bracket(const std::string& s, std::size_t open_idx) {
+    std::size_t depth = 0;
+    for (std::size_t i = open_idx; i < s.size(); ++i) {
+        if (s[i] == '[') {
+            ++depth;
+        } else if (s[i] == ']') {
+            if (depth == 0) {
+                throw std::runtime_error("Malformed JSON: stray closing bracket");
+            }
+            --depth;
+            if (depth == 0) {
+                return i;
+            }
+        }
+    }
+    throw std::runtime_error("Malformed JSON: bracket not closed");
+}
+
+std::size_t parse_size_t_after_colon(const std::string& s, std::size_t key_pos) {
+    auto colon = s.find(':', key_pos);
+    if (colon == std::string::npos) {
+        throw std::runtime_error("Malformed JSON: colon not found");
+    }
+    std::size_t idx = colon + 1;
+    while (idx < s.size() && std::isspace(static_cast<unsigned char>(s[idx]))) {
+        ++idx;
+    }
+    std::size_t end = idx;
+    while (end < s.size() && std::isdigit(static_cast<unsigned char>(s[end]))) {
+        ++end;
+    }
+    if (idx == end) {
+        throw std::runtime_error("Malformed JSON: integer expected");
+    }
+    return static_cast<std::size_t>(std::stoul(s.substr(idx, end - idx)));
+}
+
 }  // namespace
 
 Field Problem::make_field() const {
@@ -117,6 +156,33 @@ Problem Problem::from_json_string(const std::string& json) {
     return Problem{size, std::move(entities)};
 }
 
+Problem Problem::random(std::size_t size, std::uint64_t seed) {
+    std::vector<int> entities(size * size);
+    for (std::size_t i = 0; i < entities.size(); ++i) {
+        entities[i] = static_cast<int>(i / 2);
+    }
+    std::mt19937_64 engine(seed);
+    std::shuffle(entities.begin(), entities.end(), engine);
+    return Problem{size, std::move(entities)};
+}
+
+std::string Problem::to_json_string() const {
+    std::ostringstream oss;
+    oss << "{\"field\":{\"size\":" << size << ",\"entities\":[";
+    for (std::size_t y = 0; y < size; ++y) {
+        oss << (y != 0 ? ",[" : "[");
+        for (std::size_t x = 0; x < size; ++x) {
+            if (x != 0) {
+                oss << ',';
+            }
+            oss << entities[y * size + x];
+        }
+        oss << ']';
+    }
+    oss << "]}}";
+    return oss.str();
+}
+
 std::string Problem::serialize_answer(const std::vector<Operation>& ops) {
     std::ostringstream oss;
     oss << "{\n  \"ops\": [";
@@ -133,4 +199,54 @@ std::string Problem::serialize_answer(const std::vector<Operation>& ops) {
     return oss.str();
 }
 
+std::vector<Operation> Problem::parse_operations(const std::string& json) {
+    std::vector<Operation> ops;
+    constexpr std::string_view key = "\"ops\"";
+    auto pos = json.find(key);
+    if (pos == std::string::npos) {
+        return ops;
+    }
+    auto start = json.find('[', pos + key.size());
+    if (start == std::string::npos) {
+        throw std::runtime_error("Malformed ops JSON: missing array");
+    }
+    const auto end = find_matching_bracket(json, start);
+
+    std::size_t cursor = start;
+    while (true) {
+        auto x_pos = json.find("\"x\"", cursor);
+        if (x_pos == std::string::npos || x_pos > end) {
+            break;
+        }
+        std::size_t x = parse_size_t_after_colon(json, x_pos);
+
+        auto y_pos = json.find("\"y\"", x_pos + 3);
+        if (y_pos == std::string::npos || y_pos > end) {
+            throw std::runtime_error("Malformed ops JSON: missing y");
+        }
+        std::size_t y = parse_size_t_after_colon(json, y_pos);
+
+        auto n_pos = json.find("\"n\"", y_pos + 3);
+        if (n_pos == std::string::npos || n_pos > end) {
+            throw std::runtime_error("Malformed ops JSON: missing n");
+        }
+        std::size_t n = parse_size_t_after_colon(json, n_pos);
+
+        ops.push_back(Operation{x, y, n});
+        cursor = n_pos + 3;
+    }
+
+    return ops;
+}
+
+std::vector<Operation> Problem::load_operations_from_file(const std::string& path) {
+    std::ifstream ifs(path);
+    if (!ifs) {
+        throw std::runtime_error("Failed to open ops file: " + path);
+    }
+    std::ostringstream oss;
+    oss << ifs.rdbuf();
+    return parse_operations(oss.str());
+}
+
 }  // namespace proc36
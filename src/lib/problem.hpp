@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 #include <istream>
 #include <string>
 #include <vector>
@@ -19,8 +20,14 @@ struct Problem {
     static Problem load_from_stream(std::istream& is);
     static Problem load_from_file(const std::string& path);
     static Problem from_json_string(const std::string& json);
+    // Uniformly shuffled pairs 0..size*size/2-1; the same seed always gives the same instance.
+    static Problem random(std::size_t size, std::uint64_t seed);
+    // Single-line {"field":{"size":..,"entities":[[..],..]}} accepted by from_json_string.
+    [[nodiscard]] std::string to_json_string() const;
 
     static std::string serialize_answer(const std::vector<Operation>& ops);
+    static std::vector<Operation> parse_operations(const std::string& json);
+    static std::vector<Operation> load_operations_from_file(const std::string& path);
 };
 
 }  // namespace proc36
@@ -6,6 +6,14 @@
 
 namespace proc36 {
 
+[[nodiscard]] inline std::uint64_t splitmix64(std::uint64_t x) noexcept {
+    x += 0x9e3779b97f4a7c15ull;
+    x = (x ^ (x >> 30U)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27U)) * 0x94d049bb133111ebull;
+    x = x ^ (x >> 31U);
+    return x;
+}
+
 class Random {
 public:
     using engine_type = std::mt19937_64;
@@ -0,0 +1,68 @@
+#include "lib/rotation_reach.hpp"
+
+#include <algorithm>
+
+namespace proc36 {
+
+RotationReach::RotationReach(std::size_t board_size, std::vector<std::size_t> sizes)
+    : size_(board_size), sizes_(std::move(sizes)) {
+    std::erase_if(sizes_, [&](std::size_t k) { return k < 2 || k > size_; });
+    if (size_ > kTableMaxSize) {
+        return;
+    }
+    const auto cells = size_ * size_;
+    table_.assign((cells * cells + 63) / 64, 0);
+    for (std::size_t a = 0; a < cells; ++a) {
+        for (std::size_t b = a + 1; b < cells; ++b) {
+            if (solve(a, b)) {
+                for (const auto bit : {a * cells + b, b * cells + a}) {
+                    table_[bit / 64] |= std::uint64_t{1} << (bit % 64);
+                }
+            }
+        }
+    }
+}
+
+bool RotationReach::solve(std::size_t a, std::size_t b) const noexcept {
+    return moves_next_to(a, b) || moves_next_to(b, a);
+}
+
+bool RotationReach::moves_next_to(std::size_t from, std::size_t anchor) const noexcept {
+    const auto n = static_cast<long>(size_);
+    const auto px = static_cast<long>(from % size_);
+    const auto py = static_cast<long>(from / size_);
+    const auto qx = static_cast<long>(anchor % size_);
+    const auto qy = static_cast<long>(anchor / size_);
+    constexpr long kSteps[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+    for (const auto& step : kSteps) {
+        const auto tx = qx + step[0];
+        const auto ty = qy + step[1];
+        if (tx < 0 || ty < 0 || tx >= n || ty >= n) {
+            continue;
+        }
+        for (const auto size : sizes_) {
+            const auto k = static_cast<long>(size);
+            // Window (x, y) sends (px, py) to (x + k - 1 - (py - y), y + (px - x)); solve that for (tx, ty).
+            const auto sum = tx - k + 1 + py;
+            const auto difference = px - ty;
+            if (((sum + difference) & 1) != 0) {
+                continue;
+            }
+            const auto x = (sum + difference) / 2;
+            const auto y = (sum - difference) / 2;
+            if (x < 0 || y < 0 || x + k > n || y + k > n) {
+                continue;
+            }
+            if (px < x || px >= x + k || py < y || py >= y + k) {
+                continue;
+            }
+            if (qx >= x && qx < x + k && qy >= y && qy < y + k) {
+                continue;  // the window would carry the anchor along
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+}  // namespace proc36
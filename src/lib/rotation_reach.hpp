@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace proc36 {
+
+// Whether one clockwise rotation of an allowed size can make two cells adjacent. A rotation moves its window
+// rigidly, so only a window holding exactly one cell of the pair can complete it, and for a cell, a target next to
+// the other cell and a size that window is unique. Boards up to kTableMaxSize answer from a precomputed bit table,
+// larger ones solve for the window on the fly.
+class RotationReach {
+public:
+    static constexpr std::size_t kTableMaxSize = 32;
+
+    RotationReach(std::size_t board_size, std::vector<std::size_t> sizes);
+
+    [[nodiscard]] std::size_t board_size() const noexcept { return size_; }
+    // Cells are row-major indices.
+    [[nodiscard]] bool completes(std::size_t a, std::size_t b) const noexcept {
+        if (table_.empty()) {
+            return solve(a, b);
+        }
+        const auto bit = a * size_ * size_ + b;
+        return ((table_[bit / 64] >> (bit % 64)) & 1U) != 0;
+    }
+
+private:
+    [[nodiscard]] bool solve(std::size_t a, std::size_t b) const noexcept;
+    [[nodiscard]] bool moves_next_to(std::size_t from, std::size_t anchor) const noexcept;
+
+    std::size_t size_;
+    std::vector<std::size_t> sizes_;
+    std::vector<std::uint64_t> table_;  // bit a * n^2 + b
+};
+
+}  // namespace proc36
@@ -0,0 +1,260 @@
+#include "lib/socket.hpp"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+namespace proc36 {
+
+namespace {
+
+[[noreturn]] void throw_errno(const std::string& what) {
+    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        throw std::runtime_error(what + ": timed out");  // SO_RCVTIMEO / SO_SNDTIMEO expired
+    }
+    throw std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+// connect() that gives up after `timeout_ms` (when positive); errno is set on failure.
+bool connect_within(int fd, const sockaddr* address, socklen_t length, int timeout_ms) {
+    if (timeout_ms <= 0) {
+        return ::connect(fd, address, length) == 0;
+    }
+    const int flags = ::fcntl(fd, F_GETFL, 0);
+    ::fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+    bool connected = ::connect(fd, address, length) == 0;
+    if (!connected && errno == EINPROGRESS) {
+        pollfd waiting{fd, POLLOUT, 0};
+        const int ready = ::poll(&waiting, 1, timeout_ms);
+        if (ready == 0) {
+            errno = ETIMEDOUT;
+        } else if (ready > 0) {
+            int error = 0;
+            socklen_t error_length = sizeof(error);
+            ::getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &error_length);
+            connected = error == 0;
+            errno = error;
+        }
+    }
+    ::fcntl(fd, F_SETFL, flags);
+    return connected;
+}
+
+}  // namespace
+
+Socket::~Socket() {
+    close();
+}
+
+Socket::Socket(Socket&& other) noexcept
+    : fd_(std::exchange(other.fd_, -1)), buffer_(std::move(other.buffer_)) {}
+
+Socket& Socket::operator=(Socket&& other) noexcept {
+    if (this != &other) {
+        close();
+        fd_ = std::exchange(other.fd_, -1);
+        buffer_ = std::move(other.buffer_);
+    }
+    return *this;
+}
+
+Socket Socket::listen_unix(const std::string& path) {
+    sockaddr_un addr{};
+    if (path.size() >= sizeof(addr.sun_path)) {
+        throw std::runtime_error("Unix socket path too long: " + path);
+    }
+    Socket socket(::socket(AF_UNIX, SOCK_STREAM, 0));
+    if (!socket.valid()) {
+        throw_errno("socket");
+    }
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    ::unlink(path.c_str());
+    if (::bind(socket.fd_, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0) {
+        throw_errno("bind " + path);
+    }
+    if (::listen(socket.fd_, 16) != 0) {
+        throw_errno("listen " + path);
+    }
+    return socket;
+}
+
+Socket Socket::listen_tcp(std::uint16_t port, const std::string& bind_address) {
+    Socket socket(::socket(AF_INET, SOCK_STREAM, 0));
+    if (!socket.valid()) {
+        throw_errno("socket");
+    }
+    const int enable = 1;
+    ::setsockopt(socket.fd_, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if (::inet_pton(AF_INET, bind_address.c_str(), &addr.sin_addr) != 1) {
+        throw std::runtime_error("Invalid bind address: " + bind_address);
+    }
+    if (::bind(socket.fd_, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0) {
+        throw_errno("bind " + bind_address + ":" + std::to_string(port));
+    }
+    if (::listen(socket.fd_, 64) != 0) {
+        throw_errno("listen");
+    }
+    return socket;
+}
+
+Socket Socket::connect_tcp(const std::string& host, std::uint16_t port, int timeout_ms) {
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* found = nullptr;
+    const auto service = std::to_string(port);
+    if (const int rc = ::getaddrinfo(host.c_str(), service.c_str(), &hints, &found); rc != 0) {
+        throw std::runtime_error("Failed to resolve " + host + ": " + ::gai_strerror(rc));
+    }
+    Socket socket;
+    for (auto* info = found; info != nullptr; info = info->ai_next) {
+        Socket candidate(::socket(info->ai_family, info->ai_socktype, info->ai_protocol));
+        if (candidate.valid() && connect_within(candidate.fd_, info->ai_addr, info->ai_addrlen, timeout_ms)) {
+            socket = std::move(candidate);
+            break;
+        }
+    }
+    ::freeaddrinfo(found);
+    if (!socket.valid()) {
+        throw_errno("connect " + host + ":" + service);
+    }
+    const int enable = 1;
+    ::setsockopt(socket.fd_, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));  // requests are small
+    if (timeout_ms > 0) {
+        socket.set_timeout(timeout_ms);
+    }
+    return socket;
+}
+
+std::uint16_t Socket::local_port() const {
+    sockaddr_in addr{};
+    socklen_t length = sizeof(addr);
+    if (::getsockname(fd_, reinterpret_cast<sockaddr*>(&addr), &length) != 0) {
+        throw_errno("getsockname");
+    }
+    return ntohs(addr.sin_port);
+}
+
+Socket Socket::accept() const {
+    while (true) {
+        const int fd = ::accept(fd_, nullptr, nullptr);
+        if (fd >= 0) {
+            return Socket(fd);
+        }
+        if (errno != EINTR) {
+            throw_errno("accept");
+        }
+    }
+}
+
+void Socket::set_timeout(int timeout_ms) const {
+    timeval timeout{};
+    timeout.tv_sec = timeout_ms / 1000;
+    timeout.tv_usec = (timeout_ms % 1000) * 1000;
+    if (::setsockopt(fd_, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) != 0 ||
+        ::setsockopt(fd_, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout)) != 0) {
+        throw_errno("setsockopt");
+    }
+}
+
+void Socket::send_all(std::string_view data) const {
+    while (!data.empty()) {
+        const auto sent = ::send(fd_, data.data(), data.size(), MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw_errno("send");
+        }
+        data.remove_prefix(static_cast<std::size_t>(sent));
+    }
+}
+
+bool Socket::fill() {
+    char chunk[4096];
+    while (true) {
+        const auto received = ::recv(fd_, chunk, sizeof(chunk), 0);
+        if (received > 0) {
+            buffer_.append(chunk, static_cast<std::size_t>(received));
+            return true;
+        }
+        if (received == 0) {
+            return false;
+        }
+        if (errno != EINTR) {
+            throw_errno("recv");
+        }
+    }
+}
+
+bool Socket::read_line(std::string& line) {
+    std::size_t newline = 0;
+    while ((newline = buffer_.find('\n')) == std::string::npos) {
+        if (!fill()) {
+            if (buffer_.empty()) {
+                return false;
+            }
+            line = std::exchange(buffer_, std::string{});
+            return true;
+        }
+    }
+    line = buffer_.substr(0, newline);
+    buffer_.erase(0, newline + 1);
+    if (!line.empty() && line.back() == '\r') {
+        line.pop_back();
+    }
+    return true;
+}
+
+std::string Socket::read_exact(std::size_t count) {
+    while (buffer_.size() < count && fill()) {
+    }
+    const auto taken = std::min(count, buffer_.size());
+    auto data = buffer_.substr(0, taken);
+    buffer_.erase(0, taken);
+    return data;
+}
+
+std::string Socket::read_all() {
+    while (fill()) {
+    }
+    return std::exchange(buffer_, std::string{});
+}
+
+void Socket::shutdown_write() const noexcept {
+    if (valid()) {
+        ::shutdown(fd_, SHUT_WR);
+    }
+}
+
+void Socket::shutdown() const noexcept {
+    if (valid()) {
+        ::shutdown(fd_, SHUT_RDWR);
+    }
+}
+
+void Socket::close() noexcept {
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+}  // namespace proc36
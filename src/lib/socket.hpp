@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace proc36 {
+
+// Owning wrapper around a POSIX stream socket with buffered line reads. Failures throw std::runtime_error.
+class Socket {
+public:
+    Socket() = default;
+    explicit Socket(int fd) noexcept : fd_(fd) {}
+    ~Socket();
+
+    Socket(Socket&& other) noexcept;
+    Socket& operator=(Socket&& other) noexcept;
+    Socket(const Socket&) = delete;
+    Socket& operator=(const Socket&) = delete;
+
+    [[nodiscard]] bool valid() const noexcept { return fd_ >= 0; }
+    [[nodiscard]] int fd() const noexcept { return fd_; }
+
+    static Socket listen_unix(const std::string& path);
+    // Port 0 picks a free port; see local_port().
+    static Socket listen_tcp(std::uint16_t port, const std::string& bind_address = "0.0.0.0");
+    // A positive `timeout_ms` bounds the connect and, via set_timeout(), every later send and receive.
+    static Socket connect_tcp(const std::string& host, std::uint16_t port, int timeout_ms = 0);
+
+    [[nodiscard]] std::uint16_t local_port() const;
+
+    [[nodiscard]] Socket accept() const;
+
+    // Sends and receives that stall longer than `timeout_ms` throw instead of blocking; 0 waits indefinitely.
+    void set_timeout(int timeout_ms) const;
+
+    void send_all(std::string_view data) const;
+    // Next line without its terminator ("\r\n" or "\n"); false once the peer has closed and the buffer is empty.
+    bool read_line(std::string& line);
+    // Exactly `count` bytes (fewer only at end of stream).
+    [[nodiscard]] std::string read_exact(std::size_t count);
+    // Everything until the peer closes.
+    [[nodiscard]] std::string read_all();
+    void shutdown_write() const noexcept;
+    // Shuts down both directions without releasing the descriptor, so a read blocked on another thread returns.
+    void shutdown() const noexcept;
+    void close() noexcept;
+
+private:
+    bool fill();
+
+    int fd_ = -1;
+    std::string buffer_;  // bytes received but not yet returned
+};
+
+}  // namespace proc36
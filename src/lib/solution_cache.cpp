@@ -0,0 +1,116 @@
+#include "lib/solution_cache.hpp"
+
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+#include "lib/random.hpp"
+#include "lib/symmetry.hpp"
+
+namespace proc36 {
+
+namespace {
+
+constexpr std::string_view kHeader = "proc36-solution-cache v1";
+
+std::optional<std::vector<Operation>> read_entry(const std::filesystem::path& path, std::size_t board_size) {
+    std::ifstream ifs(path);
+    if (!ifs) {
+        return std::nullopt;
+    }
+    std::string header;
+    std::getline(ifs, header);
+    std::size_t size = 0;
+    std::size_t count = 0;
+    if (header != kHeader || !(ifs >> size >> count) || size != board_size) {
+        return std::nullopt;
+    }
+    std::vector<Operation> ops(count);
+    for (auto& op : ops) {
+        if (!(ifs >> op.x >> op.y >> op.size)) {
+            return std::nullopt;
+        }
+    }
+    return ops;
+}
+
+bool solves(const Problem& problem, const std::vector<Operation>& ops) {
+    auto field = problem.make_field();
+    for (const auto& op : ops) {
+        if (!field.is_valid_operation(op)) {
+            return false;
+        }
+        field.apply(op);
+    }
+    return field.is_goal_state();
+}
+
+}  // namespace
+
+SolutionCache::SolutionCache(std::filesystem::path directory) : directory_(std::move(directory)) {
+    std::filesystem::create_directories(directory_);
+}
+
+std::filesystem::path SolutionCache::entry_path(const Problem& problem) const {
+    const auto form = canonical_form(problem.make_field());
+    std::ostringstream name;
+    name << std::hex << std::setw(16) << std::setfill('0') << form.fingerprint << ".ops";
+    return directory_ / name.str();
+}
+
+std::optional<std::vector<Operation>> SolutionCache::lookup(const Problem& problem) const {
+    const auto form = canonical_form(problem.make_field());
+    auto canonical_ops = read_entry(entry_path(problem), problem.size);
+    if (!canonical_ops) {
+        return std::nullopt;
+    }
+    auto ops = transform_operations(*canonical_ops, problem.size, inverse(form.symmetry));
+    if (!solves(problem, ops)) {
+        return std::nullopt;  // fingerprint collision or stale entry
+    }
+    return ops;
+}
+
+bool SolutionCache::store(const Problem& problem, const std::vector<Operation>& ops) {
+    if (!solves(problem, ops)) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    if (const auto existing = lookup(problem); existing && existing->size() <= ops.size()) {
+        return false;
+    }
+
+    const auto form = canonical_form(problem.make_field());
+    const auto canonical_ops = transform_operations(ops, problem.size, form.symmetry);
+    const auto path = entry_path(problem);
+    auto temp = path;
+    temp += ".tmp" + std::to_string(Random().next_int<std::uint64_t>(0, ~0ULL));
+    {
+        std::ofstream ofs(temp, std::ios::trunc);
+        if (!ofs) {
+            throw std::runtime_error("Failed to open cache file: " + temp.string());
+        }
+        ofs << kHeader << '\n' << problem.size << ' ' << canonical_ops.size() << '\n';
+        for (const auto& op : canonical_ops) {
+            ofs << op.x << ' ' << op.y << ' ' << op.size << '\n';
+        }
+        ofs.flush();
+        if (!ofs) {
+            throw std::runtime_error("Failed to write cache file: " + temp.string());
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(temp, path, ec);
+    if (ec) {
+        std::filesystem::remove(temp, ec);
+        throw std::runtime_error("Failed to publish cache file: " + path.string());
+    }
+    return true;
+}
+
+}  // namespace proc36
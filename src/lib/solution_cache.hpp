@@ -0,0 +1,34 @@
+#pragma once
+
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include "lib/operation.hpp"
+#include "lib/problem.hpp"
+
+namespace proc36 {
+
+// On-disk store of the shortest known answer per problem, one file per canonical fingerprint. Answers are kept in
+// the canonical orientation so rotated or relabelled copies of an instance share an entry.
+class SolutionCache {
+public:
+    explicit SolutionCache(std::filesystem::path directory);
+
+    // Returns the cached answer mapped onto `problem`, or nullopt when there is no entry or it does not replay to
+    // the goal state.
+    [[nodiscard]] std::optional<std::vector<Operation>> lookup(const Problem& problem) const;
+
+    // Writes `ops` if it solves `problem` and is shorter than the cached entry. The file is replaced by rename, so
+    // readers never see a partial answer. Returns true when the entry was updated.
+    bool store(const Problem& problem, const std::vector<Operation>& ops);
+
+    [[nodiscard]] std::filesystem::path entry_path(const Problem& problem) const;
+
+private:
+    std::filesystem::path directory_;
+    std::mutex write_mutex_;
+};
+
+}  // namespace proc36
@@ -0,0 +1,32 @@
+#include "lib/striped_hash_set.hpp"
+
+#include <algorithm>
+#include <bit>
+
+namespace proc36 {
+
+StripedHashSet::StripedHashSet(std::size_t stripes)
+    : stripe_count_(std::bit_ceil(std::max<std::size_t>(1, stripes))),
+      shift_(static_cast<unsigned>(64 - std::countr_zero(stripe_count_))) {
+    stripes_ = std::make_unique<Stripe[]>(stripe_count_);
+}
+
+bool StripedHashSet::insert(std::uint64_t key) {
+    // A single stripe would need a shift of 64, which is undefined.
+    auto& stripe = stripes_[stripe_count_ == 1 ? 0 : static_cast<std::size_t>(key >> shift_)];
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    if (!stripe.keys.insert(key).second) {
+        return false;
+    }
+    size_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void StripedHashSet::clear() {
+    for (std::size_t i = 0; i < stripe_count_; ++i) {
+        stripes_[i].keys.clear();
+    }
+    size_.store(0, std::memory_order_relaxed);
+}
+
+}  // namespace proc36
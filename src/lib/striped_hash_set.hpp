@@ -0,0 +1,36 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+
+namespace proc36 {
+
+// Concurrent set of 64-bit state hashes split into independently locked stripes. Keys are expected to be well mixed
+// already (Zobrist or canonical hashes), so the stripe is taken from the top bits.
+class StripedHashSet {
+public:
+    explicit StripedHashSet(std::size_t stripes = 64);
+
+    // False when the key was already present.
+    bool insert(std::uint64_t key);
+    [[nodiscard]] std::size_t size() const noexcept { return size_.load(std::memory_order_relaxed); }
+    // Not safe against concurrent inserts.
+    void clear();
+
+private:
+    struct alignas(64) Stripe {
+        std::mutex mutex;
+        std::unordered_set<std::uint64_t> keys;
+    };
+
+    std::unique_ptr<Stripe[]> stripes_;
+    std::size_t stripe_count_;
+    unsigned shift_;
+    std::atomic<std::size_t> size_{0};
+};
+
+}  // namespace proc36
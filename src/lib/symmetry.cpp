@@ -0,0 +1,173 @@
+#include "lib/symmetry.hpp"
+
+#include <algorithm>
+#include <limits>
+
+#include "lib/random.hpp"
+
+namespace proc36 {
+
+namespace {
+
+constexpr std::array<Symmetry, 4> kRotations = {Symmetry::Identity, Symmetry::Rotate90, Symmetry::Rotate180,
+                                                Symmetry::Rotate270};
+
+std::vector<int> relabelled_cells(const Field& field, Symmetry symmetry) {
+    const auto n = field.size();
+    const auto& cells = field.cells();
+    const auto source = inverse(symmetry);
+    std::vector<int> labels(cells.size(), -1);
+    std::vector<int> relabelled(cells.size());
+    int next_label = 0;
+    for (std::size_t y = 0; y < n; ++y) {
+        for (std::size_t x = 0; x < n; ++x) {
+            const auto from = transform_position(Position{x, y}, n, source);
+            const auto value = cells[from.y * n + from.x];
+            if (value < 0) {
+                relabelled[y * n + x] = value;
+                continue;
+            }
+            const auto uvalue = static_cast<std::size_t>(value);
+            if (uvalue >= labels.size()) {
+                labels.resize(uvalue + 1, -1);
+            }
+            if (labels[uvalue] < 0) {
+                labels[uvalue] = next_label++;
+            }
+            relabelled[y * n + x] = labels[uvalue];
+        }
+    }
+    return relabelled;
+}
+
+}  // namespace
+
+const char* to_string(Symmetry symmetry) noexcept {
+    switch (symmetry) {
+        case Symmetry::Identity:
+            return "identity";
+        case Symmetry::Rotate90:
+            return "rotate90";
+        case Symmetry::Rotate180:
+            return "rotate180";
+        case Symmetry::Rotate270:
+            return "rotate270";
+        case Symmetry::MirrorX:
+            return "mirror_x";
+        case Symmetry::MirrorY:
+            return "mirror_y";
+        case Symmetry::Transpose:
+            return "transpose";
+        case Symmetry::AntiTranspose:
+            return "anti_transpose";
+    }
+    return "unknown";
+}
+
+Symmetry inverse(Symmetry symmetry) noexcept {
+    switch (symmetry) {
+        case Symmetry::Rotate90:
+            return Symmetry::Rotate270;
+        case Symmetry::Rotate270:
+            return Symmetry::Rotate90;
+        default:
+            return symmetry;  // every other element is an involution
+    }
+}
+
+bool preserves_orientation(Symmetry symmetry) noexcept {
+    return std::find(kRotations.begin(), kRotations.end(), symmetry) != kRotations.end();
+}
+
+Position transform_position(Position p, std::size_t board_size, Symmetry symmetry) noexcept {
+    const auto last = board_size - 1;
+    switch (symmetry) {
+        case Symmetry::Identity:
+            return p;
+        case Symmetry::Rotate90:
+            return Position{last - p.y, p.x};
+        case Symmetry::Rotate180:
+            return Position{last - p.x, last - p.y};
+        case Symmetry::Rotate270:
+            return Position{p.y, last - p.x};
+        case Symmetry::MirrorX:
+            return Position{last - p.x, p.y};
+        case Symmetry::MirrorY:
+            return Position{p.x, last - p.y};
+        case Symmetry::Transpose:
+            return Position{p.y, p.x};
+        case Symmetry::AntiTranspose:
+            return Position{last - p.y, last - p.x};
+    }
+    return p;
+}
+
+Field transform_field(const Field& field, Symmetry symmetry) {
+    const auto n = field.size();
+    const auto& cells = field.cells();
+    std::vector<int> transformed(cells.size());
+    for (std::size_t y = 0; y < n; ++y) {
+        for (std::size_t x = 0; x < n; ++x) {
+            const auto to = transform_position(Position{x, y}, n, symmetry);
+            transformed[to.y * n + to.x] = cells[y * n + x];
+        }
+    }
+    return Field(n, std::move(transformed));
+}
+
+Problem transform_problem(const Problem& problem, Symmetry symmetry) {
+    auto field = transform_field(problem.make_field(), symmetry);
+    return Problem{problem.size, field.cells()};
+}
+
+std::vector<Operation> transform_operation(const Operation& op, std::size_t board_size, Symmetry symmetry) {
+    const auto a = transform_position(Position{op.x, op.y}, board_size, symmetry);
+    const auto b = transform_position(Position{op.x + op.size - 1, op.y + op.size - 1}, board_size, symmetry);
+    const Operation mapped{std::min(a.x, b.x), std::min(a.y, b.y), op.size};
+    if (preserves_orientation(symmetry)) {
+        return {mapped};
+    }
+    return {mapped, mapped, mapped};
+}
+
+std::vector<Operation> transform_operations(const std::vector<Operation>& ops, std::size_t board_size,
+                                            Symmetry symmetry) {
+    std::vector<Operation> mapped;
+    mapped.reserve(preserves_orientation(symmetry) ? ops.size() : ops.size() * 3);
+    for (const auto& op : ops) {
+        for (const auto& m : transform_operation(op, board_size, symmetry)) {
+            mapped.push_back(m);
+        }
+    }
+    return mapped;
+}
+
+std::uint64_t canonical_hash(const Field& field) {
+    // The Zobrist hash of each rotation of the board; a field tracking them answers without a scan.
+    std::uint64_t best = field.zobrist_hash();
+    for (std::size_t turns = 1; turns < 4; ++turns) {
+        best = std::min(best, field.rotated_hash(turns));
+    }
+    return best;
+}
+
+CanonicalForm canonical_form(const Field& field) {
+    CanonicalForm form;
+    std::vector<int> best;
+    for (const auto rotation : kRotations) {
+        auto cells = relabelled_cells(field, rotation);
+        if (best.empty() || cells < best) {
+            best = std::move(cells);
+            form.symmetry = rotation;
+        }
+    }
+
+    std::uint64_t hash = splitmix64(field.size());
+    for (const auto value : best) {
+        hash = splitmix64(hash ^ static_cast<std::uint64_t>(value));
+    }
+    form.fingerprint = hash;
+    return form;
+}
+
+}  // namespace proc36
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "lib/field.hpp"
+#include "lib/operation.hpp"
+#include "lib/problem.hpp"
+
+namespace proc36 {
+
+// The 8 symmetries of the square board. Cell (x, y) moves to the position given by transform_position.
+enum class Symmetry : std::uint8_t {
+    Identity,
+    Rotate90,   // clockwise
+    Rotate180,
+    Rotate270,
+    MirrorX,    // x -> n - 1 - x
+    MirrorY,    // y -> n - 1 - y
+    Transpose,  // (x, y) -> (y, x)
+    AntiTranspose,
+};
+
+// Rotations first: they map a clockwise turn onto a clockwise turn, so solutions keep their length.
+inline constexpr std::array<Symmetry, 8> kAllSymmetries = {
+    Symmetry::Identity, Symmetry::Rotate90, Symmetry::Rotate180, Symmetry::Rotate270,
+    Symmetry::MirrorX,  Symmetry::MirrorY,  Symmetry::Transpose, Symmetry::AntiTranspose,
+};
+
+[[nodiscard]] const char* to_string(Symmetry symmetry) noexcept;
+[[nodiscard]] Symmetry inverse(Symmetry symmetry) noexcept;
+[[nodiscard]] bool preserves_orientation(Symmetry symmetry) noexcept;
+
+[[nodiscard]] Position transform_position(Position p, std::size_t board_size, Symmetry symmetry) noexcept;
+
+[[nodiscard]] Field transform_field(const Field& field, Symmetry symmetry);
+[[nodiscard]] Problem transform_problem(const Problem& problem, Symmetry symmetry);
+
+// Maps an operation on the original board to the equivalent sequence on the transformed board. Reflections turn
+// a clockwise rotation into a counter-clockwise one, which costs three clockwise rotations of the same window.
+[[nodiscard]] std::vector<Operation> transform_operation(const Operation& op, std::size_t board_size,
+                                                         Symmetry symmetry);
+[[nodiscard]] std::vector<Operation> transform_operations(const std::vector<Operation>& ops, std::size_t board_size,
+                                                          Symmetry symmetry);
+
+// Hash shared by all rotations of a field. States in one class are the same distance from the goal, so search
+// caches can key on it to avoid expanding a rotated copy of a known state.
+[[nodiscard]] std::uint64_t canonical_hash(const Field& field);
+
+// Normal form under rotations and value relabelling: values are renumbered by first appearance in row-major order
+// and the lexicographically smallest rotation wins. Two fields with the same fingerprint are the same instance.
+struct CanonicalForm {
+    Symmetry symmetry = Symmetry::Identity;  // maps the field onto its canonical orientation
+    std::uint64_t fingerprint = 0;
+};
+
+[[nodiscard]] CanonicalForm canonical_form(const Field& field);
+
+}  // namespace proc36
@@ -0,0 +1,228 @@
+#include "lib/thread_pool.hpp"
+
+#include <iostream>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace proc36 {
+
+namespace {
+
+thread_local const ThreadPool* tls_pool = nullptr;
+thread_local std::size_t tls_worker = ThreadPool::kExternalThread;
+
+// A submitted task has nobody to rethrow to, and letting it escape the worker would terminate the process.
+void report_detached_error(const std::exception_ptr& error) noexcept {
+    try {
+        std::rethrow_exception(error);
+    } catch (const std::exception& e) {
+        std::cerr << "ThreadPool: submitted task threw: " << e.what() << '\n';
+    } catch (...) {
+        std::cerr << "ThreadPool: submitted task threw a non-standard exception\n";
+    }
+}
+
+void pin_to_cpu([[maybe_unused]] std::thread& thread, [[maybe_unused]] std::size_t cpu) {
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set);
+#endif
+}
+
+}  // namespace
+
+ThreadPool::ThreadPool(std::size_t threads, bool pin_threads) {
+    const std::size_t hardware = std::max(1U, std::thread::hardware_concurrency());
+    if (threads == 0) {
+        threads = hardware;
+    }
+    workers_.reserve(threads);
+    for (std::size_t i = 0; i < threads; ++i) {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+    for (std::size_t i = 0; i < threads; ++i) {
+        workers_[i]->thread = std::thread([this, i]() { worker_loop(i); });
+        if (pin_threads) {
+            pin_to_cpu(workers_[i]->thread, i % hardware);
+        }
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (auto& worker : workers_) {
+        worker->thread.join();
+    }
+}
+
+std::size_t ThreadPool::current_worker() const noexcept {
+    return tls_pool == this ? tls_worker : kExternalThread;
+}
+
+void ThreadPool::enqueue(std::function<void()> fn, TaskGroup* group) {
+    auto self = current_worker();
+    if (self == kExternalThread) {
+        self = next_queue_.fetch_add(1, std::memory_order_relaxed) % workers_.size();
+    }
+    queued_.fetch_add(1, std::memory_order_release);  // counted before it becomes stealable
+    {
+        std::lock_guard<std::mutex> lock(workers_[self]->mutex);
+        workers_[self]->tasks.push_back(Task{std::move(fn), group, current_allocation_phase()});
+    }
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+    }
+    wake_.notify_one();
+}
+
+bool ThreadPool::pop_task(std::size_t self, const TaskGroup* only_group, Task& out) {
+    auto take = [&](std::deque<Task>& tasks, bool from_back) {
+        if (only_group == nullptr) {
+            if (tasks.empty()) {
+                return false;
+            }
+            if (from_back) {
+                out = std::move(tasks.back());
+                tasks.pop_back();
+            } else {
+                out = std::move(tasks.front());
+                tasks.pop_front();
+            }
+            return true;
+        }
+        const auto matches = [&](const Task& task) { return task.group == only_group; };
+        if (from_back) {
+            const auto it = std::find_if(tasks.rbegin(), tasks.rend(), matches);
+            if (it == tasks.rend()) {
+                return false;
+            }
+            out = std::move(*it);
+            tasks.erase(std::next(it).base());
+        } else {
+            const auto it = std::find_if(tasks.begin(), tasks.end(), matches);
+            if (it == tasks.end()) {
+                return false;
+            }
+            out = std::move(*it);
+            tasks.erase(it);
+        }
+        return true;
+    };
+
+    const auto count = workers_.size();
+    if (self != kExternalThread) {
+        std::lock_guard<std::mutex> lock(workers_[self]->mutex);
+        if (take(workers_[self]->tasks, true)) {
+            queued_.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    const auto start = self == kExternalThread ? 0 : self + 1;
+    for (std::size_t offset = 0; offset < count; ++offset) {
+        const auto victim = (start + offset) % count;
+        if (victim == self) {
+            continue;
+        }
+        std::lock_guard<std::mutex> lock(workers_[victim]->mutex);
+        if (take(workers_[victim]->tasks, false)) {
+            queued_.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ThreadPool::try_run_one(std::size_t self, const TaskGroup* only_group) {
+    Task task;
+    if (!pop_task(self, only_group, task)) {
+        return false;
+    }
+    const AllocationPhaseScope phase(task.phase);
+    std::exception_ptr error;
+    try {
+        task.fn();
+    } catch (...) {
+        error = std::current_exception();
+    }
+    if (task.group != nullptr) {
+        task.group->finish(error);
+    } else if (error) {
+        report_detached_error(error);
+    }
+    return true;
+}
+
+void ThreadPool::worker_loop(std::size_t index) {
+    tls_pool = this;
+    tls_worker = index;
+    while (true) {
+        if (try_run_one(index, nullptr)) {
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleep_mutex_);
+        wake_.wait(lock, [this]() { return stopping_ || queued_.load(std::memory_order_acquire) > 0; });
+        if (stopping_ && queued_.load(std::memory_order_acquire) == 0) {
+            return;
+        }
+    }
+}
+
+TaskGroup::~TaskGroup() {
+    try {
+        wait();
+    } catch (...) {
+        // errors are only reported through an explicit wait()
+    }
+}
+
+void TaskGroup::run(std::function<void()> task) {
+    pending_.fetch_add(1, std::memory_order_relaxed);
+    pool_.enqueue(std::move(task), this);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+    }
+    changed_.notify_all();  // a waiter blocked in wait() can now take it
+}
+
+void TaskGroup::wait() {
+    const auto self = pool_.current_worker();
+    while (true) {
+        const auto pending = pending_.load(std::memory_order_acquire);
+        if (pending == 0) {
+            break;
+        }
+        if (pool_.try_run_one(self, this)) {
+            continue;
+        }
+        // None of the group's tasks is left to take, so the rest are running elsewhere: sleep until one finishes or
+        // a running one forks another.
+        std::unique_lock<std::mutex> lock(mutex_);
+        changed_.wait(lock, [&]() { return pending_.load(std::memory_order_acquire) != pending; });
+    }
+    // Taking the lock also waits out a finish() still inside it, so the group may be destroyed once this returns.
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (error_) {
+        auto error = std::exchange(error_, nullptr);
+        std::rethrow_exception(error);
+    }
+}
+
+void TaskGroup::finish(std::exception_ptr error) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (error && !error_) {
+        error_ = error;
+    }
+    pending_.fetch_sub(1, std::memory_order_acq_rel);
+    changed_.notify_all();
+}
+
+}  // namespace proc36
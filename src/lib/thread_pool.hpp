@@ -0,0 +1,138 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "lib/allocation_stats.hpp"
+
+namespace proc36 {
+
+class TaskGroup;
+
+// Work-stealing pool shared by the solver engines. Every worker owns a deque: it pushes and pops its own tasks at
+// the back and steals from the front of the others when it runs dry. Threads waiting on a TaskGroup help by
+// running that group's queued tasks, so fork/join can nest inside pool tasks without deadlocking.
+class ThreadPool {
+public:
+    static constexpr std::size_t kExternalThread = static_cast<std::size_t>(-1);
+
+    // 0 threads means std::thread::hardware_concurrency(). Pinning binds worker i to CPU i (Linux only).
+    explicit ThreadPool(std::size_t threads = 0, bool pin_threads = false);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    [[nodiscard]] std::size_t size() const noexcept { return workers_.size(); }
+
+    // Index of the calling worker of this pool, or kExternalThread.
+    [[nodiscard]] std::size_t current_worker() const noexcept;
+
+    // Fire and forget: an exception escaping `task` is reported on std::cerr and otherwise dropped.
+    void submit(std::function<void()> task) { enqueue(std::move(task), nullptr); }
+
+    // Runs fn(i) for every i in [begin, end), `grain` indices per task. The caller joins in.
+    template <class Fn>
+    void parallel_for(std::size_t begin, std::size_t end, std::size_t grain, Fn&& fn);
+
+private:
+    friend class TaskGroup;
+
+    struct Task {
+        std::function<void()> fn;
+        TaskGroup* group = nullptr;
+        AllocationPhase phase = AllocationPhase::Other;  // of the thread that queued it
+    };
+
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+        std::thread thread;
+    };
+
+    void enqueue(std::function<void()> fn, TaskGroup* group);
+    bool try_run_one(std::size_t self, const TaskGroup* only_group);
+    bool pop_task(std::size_t self, const TaskGroup* only_group, Task& out);
+    void worker_loop(std::size_t index);
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::mutex sleep_mutex_;
+    std::condition_variable wake_;
+    std::atomic<std::size_t> queued_{0};
+    std::atomic<std::size_t> next_queue_{0};
+    bool stopping_ = false;
+};
+
+// Fork/join scope: run() forks a task onto the pool, wait() joins all of them and rethrows the first exception.
+// wait() runs the group's queued tasks itself and blocks once the rest are all running elsewhere.
+class TaskGroup {
+public:
+    explicit TaskGroup(ThreadPool& pool) : pool_(pool) {}
+    ~TaskGroup();
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    void run(std::function<void()> task);
+    void wait();
+
+private:
+    friend class ThreadPool;
+
+    void finish(std::exception_ptr error);
+
+    ThreadPool& pool_;
+    std::atomic<std::size_t> pending_{0};
+    std::mutex mutex_;  // guards error_ and orders finish() against a blocked wait()
+    std::condition_variable changed_;
+    std::exception_ptr error_;
+};
+
+// One T per pool worker plus one for external threads, for scratch buffers reused across tasks. Only one external
+// thread at a time may use the shared external slot.
+template <class T>
+class WorkerLocal {
+public:
+    explicit WorkerLocal(const ThreadPool& pool, const T& init = T{}) : pool_(pool), slots_(pool.size() + 1, init) {}
+
+    [[nodiscard]] T& local() {
+        const auto worker = pool_.current_worker();
+        return slots_[worker == ThreadPool::kExternalThread ? slots_.size() - 1 : worker];
+    }
+
+    [[nodiscard]] std::vector<T>& all() noexcept { return slots_; }
+
+private:
+    const ThreadPool& pool_;
+    std::vector<T> slots_;
+};
+
+template <class Fn>
+void ThreadPool::parallel_for(std::size_t begin, std::size_t end, std::size_t grain, Fn&& fn) {
+    if (begin >= end) {
+        return;
+    }
+    grain = std::max<std::size_t>(1, grain);
+    TaskGroup group(*this);
+    for (std::size_t chunk = begin; chunk < end; chunk += grain) {
+        const auto chunk_end = std::min(end, chunk + grain);
+        group.run([&fn, chunk, chunk_end]() {
+            for (std::size_t i = chunk; i < chunk_end; ++i) {
+                fn(i);
+            }
+        });
+    }
+    group.wait();
+}
+
+}  // namespace proc36
@@ -10,18 +10,40 @@ public:
 
     Timer() : start_(clock::now()) {}
 
-    void reset() noexcept { start_ = clock::now(); }
+    void reset() noexcept {
+        start_ = clock::now();
+        paused_ = false;
+    }
+
+    // While paused the elapsed time stands still; resume() continues from where it stopped.
+    void pause() noexcept {
+        if (!paused_) {
+            paused_at_ = clock::now();
+            paused_ = true;
+        }
+    }
+
+    void resume() noexcept {
+        if (paused_) {
+            start_ += clock::now() - paused_at_;
+            paused_ = false;
+        }
+    }
 
     [[nodiscard]] double elapsed_ms() const noexcept {
-        return std::chrono::duration<double, std::milli>(clock::now() - start_).count();
+        return std::chrono::duration<double, std::milli>(now() - start_).count();
     }
 
     [[nodiscard]] double elapsed_sec() const noexcept {
-        return std::chrono::duration<double>(clock::now() - start_).count();
+        return std::chrono::duration<double>(now() - start_).count();
     }
 
 private:
+    [[nodiscard]] clock::time_point now() const noexcept { return paused_ ? paused_at_ : clock::now(); }
+
     clock::time_point start_;
+    clock::time_point paused_at_{};
+    bool paused_ = false;
 };
 
 }  // namespace proc36
@@ -0,0 +1,193 @@
+#include "lib/trajectory.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <numeric>
+#include <stdexcept>
+
+namespace proc36 {
+
+namespace {
+
+std::size_t stride_for(std::size_t length) {
+    return std::max<std::size_t>(1, static_cast<std::size_t>(std::ceil(std::sqrt(static_cast<double>(length)))));
+}
+
+}  // namespace
+
+Trajectory::Trajectory(Field initial, std::vector<Operation> ops)
+    : initial_(std::move(initial)), ops_(std::move(ops)), stride_(stride_for(ops_.size())) {
+    for (const auto& op : ops_) {
+        if (!initial_.is_valid_operation(op)) {
+            throw std::invalid_argument("Trajectory: invalid operation");
+        }
+    }
+    rebuild();
+}
+
+Field Trajectory::state_at(std::size_t index) const {
+    if (index > ops_.size()) {
+        throw std::out_of_range("Trajectory::state_at: index out of range");
+    }
+    const auto block = static_cast<std::size_t>(std::upper_bound(bounds_.begin(), bounds_.end(), index) -
+                                                bounds_.begin()) - 1;
+    Field field = snapshot(block);
+    replay(field, bounds_[block], index);
+    return field;
+}
+
+Field Trajectory::final_state_with_replacement(std::size_t begin, std::size_t end,
+                                               const std::vector<Operation>& replacement) const {
+    if (begin > end || end > ops_.size()) {
+        throw std::out_of_range("Trajectory: replacement range out of range");
+    }
+    Field field = state_at(begin);
+    for (const auto& op : replacement) {
+        field.apply(op);
+    }
+    // Finish the block containing `end` by replay, then jump over every later block with one gather.
+    const auto next_block =
+        static_cast<std::size_t>(std::lower_bound(bounds_.begin(), bounds_.end(), end) - bounds_.begin());
+    replay(field, end, bounds_[next_block]);
+    if (next_block < block_count()) {
+        field = gather(field, suffix(next_block));
+    }
+    return field;
+}
+
+void Trajectory::replace(std::size_t begin, std::size_t end, const std::vector<Operation>& replacement) {
+    if (begin > end || end > ops_.size()) {
+        throw std::out_of_range("Trajectory: replacement range out of range");
+    }
+    for (const auto& op : replacement) {
+        if (!initial_.is_valid_operation(op)) {
+            throw std::invalid_argument("Trajectory: invalid operation");
+        }
+    }
+    ops_.erase(ops_.begin() + static_cast<std::ptrdiff_t>(begin), ops_.begin() + static_cast<std::ptrdiff_t>(end));
+    ops_.insert(ops_.begin() + static_cast<std::ptrdiff_t>(begin), replacement.begin(), replacement.end());
+
+    const auto stride = stride_for(ops_.size());
+    if (block_count() == 0 || stride * 2 < stride_ || stride > stride_ * 2) {
+        stride_ = stride;
+        rebuild();
+        return;
+    }
+
+    // Only the blocks overlapping [begin, end) change; they are re-cut and replayed, later ones just shift.
+    const auto count = block_count();
+    const auto locate = [&](std::size_t index) {
+        const auto block = static_cast<std::size_t>(std::upper_bound(bounds_.begin(), bounds_.end(), index) -
+                                                    bounds_.begin()) - 1;
+        return std::min(block, count - 1);
+    };
+    const auto first = locate(begin);
+    const auto last = end > begin ? locate(end - 1) : first;
+    const auto shift = static_cast<std::ptrdiff_t>(replacement.size()) - static_cast<std::ptrdiff_t>(end - begin);
+    const auto segment_end = static_cast<std::size_t>(static_cast<std::ptrdiff_t>(bounds_[last + 1]) + shift);
+
+    std::vector<std::size_t> bounds(bounds_.begin(), bounds_.begin() + static_cast<std::ptrdiff_t>(first));
+    std::vector<Permutation> perms;
+    perms.reserve(count + 1);
+    std::move(perms_.begin(), perms_.begin() + static_cast<std::ptrdiff_t>(first), std::back_inserter(perms));
+    split(bounds_[first], segment_end, bounds, perms);
+    const auto tail = perms.size();  // new index of the first block after the edit
+    for (std::size_t b = last + 1; b <= count; ++b) {
+        bounds.push_back(static_cast<std::size_t>(static_cast<std::ptrdiff_t>(bounds_[b]) + shift));
+    }
+    std::move(perms_.begin() + static_cast<std::ptrdiff_t>(last + 1), perms_.end(), std::back_inserter(perms));
+
+    // Suffixes from the blocks after the edit are unchanged; earlier ones and the snapshots after it are stale.
+    std::vector<Permutation> suffixes(perms.size());
+    const auto kept_from = std::max(suffixes_from_, last + 1);
+    for (std::size_t b = kept_from; b < count; ++b) {
+        suffixes[b - (last + 1) + tail] = std::move(suffixes_[b]);
+    }
+    suffixes_from_ = kept_from - (last + 1) + tail;
+    suffixes_ = std::move(suffixes);
+    bounds_ = std::move(bounds);
+    perms_ = std::move(perms);
+    snapshots_.resize(perms_.size() + 1);
+    snapshots_valid_ = std::min(snapshots_valid_, first + 1);
+}
+
+void Trajectory::rebuild() {
+    bounds_.clear();
+    perms_.clear();
+    split(0, ops_.size(), bounds_, perms_);
+    bounds_.push_back(ops_.size());
+    snapshots_.assign(perms_.size() + 1, Field{});
+    snapshots_[0] = initial_;
+    snapshots_valid_ = 1;
+    suffixes_.assign(perms_.size(), Permutation{});
+    suffixes_from_ = perms_.size();
+}
+
+void Trajectory::split(std::size_t begin, std::size_t end, std::vector<std::size_t>& bounds,
+                       std::vector<Permutation>& perms) const {
+    const auto length = end - begin;
+    const auto pieces = (length + stride_ - 1) / stride_;
+    for (std::size_t i = 0; i < pieces; ++i) {
+        const auto from = begin + length * i / pieces;
+        const auto to = begin + length * (i + 1) / pieces;
+        bounds.push_back(from);
+        perms.push_back(block_permutation(from, to));
+    }
+}
+
+const Field& Trajectory::snapshot(std::size_t block) const {
+    for (; snapshots_valid_ <= block; ++snapshots_valid_) {
+        snapshots_[snapshots_valid_] = gather(snapshots_[snapshots_valid_ - 1], perms_[snapshots_valid_ - 1]);
+    }
+    return snapshots_[block];
+}
+
+const Trajectory::Permutation& Trajectory::suffix(std::size_t block) const {
+    for (; suffixes_from_ > block; --suffixes_from_) {
+        const auto b = suffixes_from_ - 1;
+        const auto& head = perms_[b];
+        if (b + 1 == block_count()) {
+            suffixes_[b] = head;
+            continue;
+        }
+        const auto& tail = suffixes_[b + 1];
+        Permutation composed(head.size());
+        for (std::size_t i = 0; i < composed.size(); ++i) {
+            composed[i] = head[tail[i]];
+        }
+        suffixes_[b] = std::move(composed);
+    }
+    return suffixes_[block];
+}
+
+Trajectory::Permutation Trajectory::block_permutation(std::size_t begin, std::size_t end) const {
+    // Rotating a board labelled with its own cell indices yields the gather permutation directly.
+    std::vector<int> labels(initial_.cell_count());
+    std::iota(labels.begin(), labels.end(), 0);
+    Field field(initial_.size(), std::move(labels));
+    replay(field, begin, end);
+    const auto& cells = field.cells();
+    Permutation perm(cells.size());
+    for (std::size_t i = 0; i < cells.size(); ++i) {
+        perm[i] = static_cast<std::uint32_t>(cells[i]);
+    }
+    return perm;
+}
+
+Field Trajectory::gather(const Field& field, const Permutation& perm) const {
+    const auto& cells = field.cells();
+    std::vector<int> out(cells.size());
+    for (std::size_t i = 0; i < out.size(); ++i) {
+        out[i] = cells[perm[i]];
+    }
+    return Field(field.size(), std::move(out));
+}
+
+void Trajectory::replay(Field& field, std::size_t begin, std::size_t end) const {
+    for (std::size_t i = begin; i < end; ++i) {
+        field.apply(ops_[i]);
+    }
+}
+
+}  // namespace proc36
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "lib/field.hpp"
+#include "lib/operation.hpp"
+
+namespace proc36 {
+
+// Board states along an operation list, cut into blocks of about sqrt(L) operations. Each block caches its composed
+// cell permutation, so the state after op i and the final state after replacing a range cost O(n^2 + sqrt(L) * k^2)
+// instead of a replay from the start. Snapshots at block starts and the permutations of every suffix of blocks are
+// rebuilt lazily, only as far as a query reaches; an edit replays only the blocks it touches.
+class Trajectory {
+public:
+    Trajectory(Field initial, std::vector<Operation> ops);
+
+    [[nodiscard]] std::size_t size() const noexcept { return ops_.size(); }
+    [[nodiscard]] const std::vector<Operation>& operations() const noexcept { return ops_; }
+
+    // State after the first `index` operations (0 is the initial field, size() the final one).
+    [[nodiscard]] Field state_at(std::size_t index) const;
+    [[nodiscard]] Field final_state() const { return state_at(ops_.size()); }
+
+    // Final state if ops [begin, end) were replaced by `replacement`, without modifying the trajectory.
+    [[nodiscard]] Field final_state_with_replacement(std::size_t begin, std::size_t end,
+                                                     const std::vector<Operation>& replacement) const;
+
+    void replace(std::size_t begin, std::size_t end, const std::vector<Operation>& replacement);
+
+private:
+    using Permutation = std::vector<std::uint32_t>;  // gather form: after[i] = before[perm[i]]
+
+    void rebuild();
+    // Blocks of ops [begin, end), each of at most stride_ operations.
+    void split(std::size_t begin, std::size_t end, std::vector<std::size_t>& bounds,
+               std::vector<Permutation>& perms) const;
+    [[nodiscard]] std::size_t block_count() const noexcept { return perms_.size(); }
+    [[nodiscard]] const Field& snapshot(std::size_t block) const;
+    [[nodiscard]] const Permutation& suffix(std::size_t block) const;
+    [[nodiscard]] Permutation block_permutation(std::size_t begin, std::size_t end) const;
+    [[nodiscard]] Field gather(const Field& field, const Permutation& perm) const;
+    void replay(Field& field, std::size_t begin, std::size_t end) const;
+
+    Field initial_;
+    std::vector<Operation> ops_;
+    std::size_t stride_ = 1;
+    std::vector<std::size_t> bounds_;  // block b holds ops [bounds_[b], bounds_[b + 1]); the last entry is size()
+    std::vector<Permutation> perms_;   // perms_[b]: the operations of block b composed
+    mutable std::vector<Field> snapshots_;       // snapshots_[b]: state after bounds_[b] operations
+    mutable std::size_t snapshots_valid_ = 0;    // snapshots_[0, snapshots_valid_) are current
+    mutable std::vector<Permutation> suffixes_;  // suffixes_[b]: blocks [b, block_count()) composed
+    mutable std::size_t suffixes_from_ = 0;      // suffixes_[suffixes_from_, block_count()) are current
+};
+
+}  // namespace proc36
@@ -1,124 +1,333 @@
 #include "solver/beam_stack_search.hpp"
 
 #include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <iterator>
 #include <limits>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
 #include <unordered_set>
 #include <utility>
 
+#include "lib/allocation_stats.hpp"
+#include "lib/memory_budget.hpp"
+#include "lib/pair_index.hpp"
+#include "lib/striped_hash_set.hpp"
+#include "lib/symmetry.hpp"
+#include "lib/thread_pool.hpp"
+#include "lib/trajectory.hpp"
+#include "solver/search_policies.hpp"
+
 namespace proc36 {
 
-BeamStackSearchSolver::BeamStackSearchSolver(BeamStackSearchConfig config)
-    : config_(std::move(config)) {}
+namespace {
+
+constexpr std::size_t kMaxPrunedWindow = 4;  // four turns of one window are the longest no-op
+constexpr std::size_t kVisitedEntryBytes = 40;  // hash node, allocator header and bucket slot
+constexpr std::size_t kNoCandidate = std::numeric_limits<std::size_t>::max();
+constexpr std::size_t kParallelRefinementMin = 32;  // smaller refinement scans stay on the calling thread
+constexpr std::size_t kRefinementGrain = 16;  // fewest candidates per refinement task
+constexpr double kMaxJitter = 1e-3;  // tie-breaking noise added to every score
+
+// Whether `metrics` has fewer unmatched pairs than `best`, or as many at a smaller total distance.
+bool beats(const PairMetrics& metrics, const PairMetrics* best) noexcept {
+    return best != nullptr &&
+           (metrics.status.unmatched < best->status.unmatched ||
+            (metrics.status.unmatched == best->status.unmatched &&
+             metrics.total_unmatched_distance < best->total_unmatched_distance));
+}
 
-std::vector<Operation> BeamStackSearchSolver::generate_operations(const Field& field,
-                                                                  const std::vector<Operation>& history,
-                                                                  const PairMetrics& metrics) const {
-    const auto board_size = field.size();
-    std::vector<Operation> operations;
-    operations.reserve(board_size * board_size);
+// Heap footprint estimate of a search node.
+template <typename Node>
+std::size_t node_bytes(const Node& node) noexcept {
+    return sizeof(Node) + node.field.cell_count() * sizeof(int) + node.field.tracking_bytes() +
+           node.operations.capacity() * sizeof(Operation) + node.metrics.unmatched_mask.capacity();
+}
 
-    struct Candidate {
-        Operation op;
-        std::size_t impact;
-    };
-    std::vector<Candidate> candidates;
+template <typename Node>
+std::size_t nodes_bytes(const std::vector<Node>& nodes) noexcept {
+    std::size_t bytes = nodes.capacity() * sizeof(Node);
+    for (const auto& node : nodes) {
+        bytes += node_bytes(node) - sizeof(Node);
+    }
+    return bytes;
+}
 
-    const Operation* last_op = history.empty() ? nullptr : &history.back();
-    const bool use_mask = metrics.status.unmatched > 0 && metrics.unmatched_mask.size() == field.cell_count();
-    std::vector<std::size_t> prefix;
+}  // namespace
+
+const char* to_string(SolvePhase phase) noexcept {
+    switch (phase) {
+        case SolvePhase::Search:
+            return "search";
+        case SolvePhase::Refinement:
+            return "refinement";
+        case SolvePhase::Shortening:
+            return "shortening";
+        case SolvePhase::Finished:
+            return "finished";
+    }
+    return "unknown";
+}
 
-    auto area_sum = [&](std::size_t x0, std::size_t y0, std::size_t k) -> std::size_t {
-        if (!use_mask) {
-            return 1;  // treat as impactful to avoid pruning everything
-        }
-        const std::size_t stride = board_size + 1;
-        const std::size_t x1 = x0 + k;
-        const std::size_t y1 = y0 + k;
-        return prefix[y1 * stride + x1] - prefix[y0 * stride + x1] - prefix[y1 * stride + x0] + prefix[y0 * stride + x0];
-    };
+void SearchStats::accumulate(const SearchStats& other) noexcept {
+    search_nodes += other.search_nodes;
+    shake_nodes += other.shake_nodes;
+    refinement_nodes += other.refinement_nodes;
+    shortening_nodes += other.shortening_nodes;
+    duplicate_hits += other.duplicate_hits;
+    duplicate_misses += other.duplicate_misses;
+    visited_clears += other.visited_clears;
+    iterations += other.iterations;
+    shakes_accepted += other.shakes_accepted;
+    bound_rejections += other.bound_rejections;
+    delta_rejections += other.delta_rejections;
+    overshoot_ms = std::max(overshoot_ms, other.overshoot_ms);
+}
 
-    if (use_mask) {
-        prefix.assign((board_size + 1) * (board_size + 1), 0);
-        const std::size_t stride = board_size + 1;
-        for (std::size_t y = 0; y < board_size; ++y) {
-            for (std::size_t x = 0; x < board_size; ++x) {
-                const auto value = static_cast<std::size_t>(metrics.unmatched_mask[y * board_size + x]);
-                prefix[(y + 1) * stride + (x + 1)] = value + prefix[y * stride + (x + 1)] +
-                                                     prefix[(y + 1) * stride + x] - prefix[y * stride + x];
-            }
-        }
-        candidates.reserve(board_size * board_size);
+bool is_better_result(const BeamStackSearchResult& a, const BeamStackSearchResult& b) noexcept {
+    if (a.solved != b.solved) {
+        return a.solved;
+    }
+    if (a.solved) {
+        return a.operations.size() < b.operations.size();
+    }
+    if (a.status.unmatched != b.status.unmatched) {
+        return a.status.unmatched < b.status.unmatched;
     }
+    return a.operations.size() < b.operations.size();
+}
 
-    for (auto size : config_.rotation_sizes) {
-        if (size < 2 || size > board_size) {
+BeamStackSearchConfig make_default_config(std::size_t board_size) {
+    BeamStackSearchConfig config;
+    config.early_rejection = true;
+    if (board_size > 8) {
+        config.rotation_sizes = {2, 3, 4, 5};
+        config.beam_width = 96;
+        config.max_depth = 28;
+        config.max_children_per_node = 48;
+        config.operation_penalty = 0.05;
+        config.time_limit_ms = 4800.0;
+    }
+    if (board_size >= 16) {
+        config.rotation_sizes = {2, 3, 4, 5, 6};
+        config.beam_width = 128;
+        config.max_depth = 40;
+        config.max_nodes = 200'000;
+        config.max_children_per_node = 64;
+        config.operation_penalty = 0.03;
+    }
+    if (board_size >= 22) {
+        config.beam_width = 160;
+        config.max_depth = 48;
+        config.max_nodes = 300'000;
+        config.time_limit_ms = 4900.0;
+        config.operation_penalty = 0.02;
+    }
+    if (board_size >= 32) {
+        config.beam_width_cap = 256;  // the adaptive beam grows with n^1.35; uncapped a 64x64 layer takes seconds
+        config.incremental_metrics = true;
+        config.candidate_limit = 240;
+    }
+    return config;
+}
+
+template <typename Evaluator, typename CandidateGenerator, typename Selector>
+BasicBeamStackSearchSolver<Evaluator, CandidateGenerator, Selector>::BasicBeamStackSearchSolver(
+    BeamStackSearchConfig config)
+    : config_(std::move(config)), random_(config_.seed != 0 ? Random(config_.seed) : Random()) {}
+
+template <typename Evaluator, typename CandidateGenerator, typename Selector>
+std::vector<Operation> BasicBeamStackSearchSolver<Evaluator, CandidateGenerator, Selector>::generate_operations(
+    const Field& field, const std::vector<Operation>& history, const PairMetrics& metrics) const {
+    auto operations = CandidateGenerator::generate(config_, field, history, metrics);
+    if (bandit_ == nullptr || operations.size() <= config_.bandit_candidate_budget) {
+        return operations;
+    }
+    // Keeps the generator's order, so each size contributes its most promising windows.
+    auto quotas = bandit_->quotas(config_.bandit_candidate_budget);
+    std::erase_if(operations, [&](const Operation& op) {
+        const auto arm = bandit_->arm_of(op.size);
+        if (arm >= quotas.size() || quotas[arm] == 0) {
+            return true;
+        }
+        --quotas[arm];
+        return false;
+    });
+    return operations;
+}
+
+template <typename Evaluator, typename CandidateGenerator, typename Selector>
+void BasicBeamStackSearchSolver<Evaluator, CandidateGenerator, Selector>::record_rotation_rewards(
+    const Node& parent, const std::vector<Node>& children) const {
+    if (bandit_ == nullptr || children.empty()) {
+        return;
+    }
+    const auto& sizes = bandit_->sizes();
+    std::vector<std::size_t> pulls(sizes.size(), 0);
+    std::vector<std::size_t> rewards(sizes.size(), 0);
+    const auto& before = parent.metrics;
+    for (const auto& child : children) {
+        const auto arm = bandit_->arm_of(child.operations.back().size);
+        if (arm >= sizes.size()) {
             continue;
         }
-        for (std::size_t y = 0; y + size <= board_size; ++y) {
-            for (std::size_t x = 0; x + size <= board_size; ++x) {
-                Operation op{x, y, size};
-                if (!field.is_valid_operation(op)) {
-                    continue;
-                }
-                if (last_op != nullptr && last_op->x == op.x && last_op->y == op.y && last_op->size == op.size) {
-                    continue;  // avoid immediately re-applying the same rotation
-                }
-                const auto impact = area_sum(x, y, size);
-                if (use_mask && impact == 0) {
-                    continue;  // skip operations that don't touch any unmatched cells
-                }
-                if (use_mask) {
-                    candidates.push_back(Candidate{op, impact});
-                } else {
-                    operations.push_back(op);
-                }
-            }
+        ++pulls[arm];
+        const auto& after = child.metrics;
+        if (after.status.unmatched < before.status.unmatched) {
+            rewards[arm] += 2;
+        } else if (after.status.unmatched == before.status.unmatched &&
+                   after.total_unmatched_distance < before.total_unmatched_distance) {
+            rewards[arm] += 1;
         }
     }
-
-    if (use_mask) {
-        std::stable_sort(candidates.begin(), candidates.end(),
-                         [](const Candidate& a, const Candidate& b) { return a.impact > b.impact; });
-        operations.reserve(candidates.size());
-        for (const auto& candidate : candidates) {
-            operations.push_back(candidate.op);
-        }
+    for (std::size_t arm = 0; arm < sizes.size(); ++arm) {
+        bandit_->record(arm, pulls[arm], rewards[arm]);
     }
+}
 
-    return operations;
+template <typename Evaluator, typename CandidateGenerator, typename Selector>
+double BasicBeamStackSearchSolver<Evaluator, CandidateGenerator, Selector>::evaluate(const Node& node) const {
+    return evaluate(node, random_);
+}
+
+template <typename Evaluator, typename CandidateGenerator, typename Selector>
+double BasicBeamStackSearchSolver<Evaluator, CandidateGenerator, Selector>::evaluate(
+    const Node& node, Random& random) const {
+    return evaluate(node.metrics, node.depth, node.operations.size(), random);
 }
 
-double BeamStackSearchSolver::evaluate(const Node& node) const {
-    const auto& status = node.metrics.status;
-    const double matched_score = config_.match_weight * static_cast<double>(status.matched);
-    const double unmatched_penalty = config_.unmatched_penalty * static_cast<double>(status.unmatched);
-    const double total_distance_penalty =
-        config_.total_distance_penalty * static_cast<double>(node.metrics.total_unmatched_distance);
-    const double max_distance_penalty =
-        config_.max_distance_penalty * static_cast<double>(node.metrics.max_unmatched_distance);
-    const double depth_penalty = config_.depth_penalty * static_cast<double>(node.depth);
-    const double op_penalty = config_.operation_penalty * static_cast<double>(node.operations.size());
-    const double jitter = random_.next_real(0.0, 1.0) * 1e-3;
-    double score = matched_score - unmatched_penalty - total_distance_penalty - max_distance_penalty - depth_penalty -
-                   op_penalty + jitter;
-    if (status.unmatched == 0) {
+template <typename Evaluator, typename CandidateGenerator, typename Selector>
+double BasicBeamStackSearchSolver<Evaluator, CandidateGenerator, Selector>::evaluate(
+    const PairMetrics& metrics, std::size_t depth, std::size_t length, Random& random) const {
+    const double jitter = random.next_real(0.0, 1.0) * kMaxJitter;
+    double score = Evaluator::score(config_, metrics, depth, length) + jitter;
+    if (metrics.status.unmatched == 0) {
         score += 1e6;  // strongly prefer solved states
     }
     return score;
 }
 
-void BeamStackSearchSolver::update_best(const Node& node, BeamStackSearchResult& best_result, double& best_score) const {
+template <typename Evaluator, typename CandidateGenerator, typename Selector>
+std::uint64_t BasicBeamStackSearchSolver<Evaluator, CandidateGenerator, Selector>::state_hash(
+    const Field& field) const {
+    return config_.canonical_hashing ? canonical_hash(field) : field.zobrist_hash();
+}
+
+template <typename Evaluator, typename CandidateGenerator, typename Selector>
+Field BasicBeamStackSearchSolver<Evaluator, CandidateGenerator, Selector>::start_field(const Problem& problem) const {
+    auto field = problem.make_field();
+    field.track_one_rotation_pairs(reach_.get());
+    if (config_.canonical_hashing) {
+        field.track_rotated_hashes();
+    }
+    return field;
+}
+
+template <typename Evaluator, typename CandidateGenerator, typename Selector>
+PairMetrics BasicBeamStackSearchSolver<Evaluator, CandidateGenerator, Selector>::root_metrics(
+    const Field& field) const {
+    auto metrics = field.evaluate_pair_metrics();
+    if (config_.lock_completed_edges) {
+        metrics.active = field.shrink_active(metrics.active);
+    }
+    return metrics;
+}
+
+template <typename Evaluator, typename CandidateGenerator, typename Selector>
+PairMetrics BasicBeamStackSearchSolver<Evaluator, CandidateGenerator, Selector>::child_metrics(
+    const Field& field, const PairMetrics& parent) const {
+    if (!config_.lock_completed_edges || parent.active.empty()) {
+        return root_metrics(field);
+    }
+    auto metrics = field.evaluate_pair_metrics(parent.active);
+    metrics.active = field.shrink_active(parent.active);
+    return metrics;
+}
+
+template <typename Evaluator, typename CandidateGenerator, typename Selector>
+PairMetrics BasicBeamStackSearchSolver<Evaluator, CandidateGenerator, Selector>::child_metrics(
+    const Field& field, const PairMetrics& parent, const Operation& op, const std::optional<PairIndex>& index) const {
+    if (!index) {
+        return child_metrics(field, parent);
+    }
+    thread_local PairIndex::Scratch scratch;
+    return finish_child_metrics(field, parent, index->metrics_after(op, scratch));
+}
+
+template <typename Evaluator, typename CandidateGenerator, typename Selector>
+PairMetrics BasicBeamStackSearchSolver<Evaluator, CandidateGenerator, Selector>::child_metrics(
+    const Field& field, const PairMetrics& parent, const Operation& op, const std::optional<PairIndex>& index,
+    ChildScreen& screen) const {
+    if (!screen.exact) {
+        return child_metrics(field, parent, op, index);
+    }
+    auto metrics = finish_child_metrics(field, parent, std::move(*screen.exact));
+    screen.exact.reset();
+    return metrics;
+}
+
+template <typename Evaluator, typename CandidateGenerator, typename Selector>
+PairMetrics BasicBeamStackSearchSolver<Evaluator, CandidateGenerator, Selector>::finish_child_metrics(
+    const Field& field, const PairMetrics& parent, PairMetrics metrics) const {
+    // Frozen strips hold matched pairs only, so whole-board counts equal those of a scan of the active rectangle.
+    metrics.one_rotation_pairs = field.one_rotation_pairs();
+    if (config_.lock_completed_edges) {
+        metrics.active = field.shrink_active(parent.active.empty() ? Rect{0, 0, field.size(), field.size()}
+                                                                   : parent.active);
+    }
+    return metrics;
+}
+
+template <typename Evaluator, typename CandidateGenerator, typename Selector>
+std::optional<PairIndex> BasicBeamStackSearchSolver<Evaluator, CandidateGenerator, Selector>::parent_index(
+    const Field& field) const {
+    if (!config_.incremental_metrics) {
+        return std::nullopt;
+    }
+    return PairIndex(field);
+}
+
+template <typename Evaluator, typename CandidateGenerator, typename Selector>
+void BasicBeamStackSearchSolver<Evaluator, CandidateGenerator, Selector>::update_best(
+    const Node& node, BeamStackSearchResult& best_result, double& best_score) const {
     const double score = node.score;
-    if (score > best_score) {
-        best_score = score;
-        best_result.operations = node.operations;
-        best_result.status = node.metrics.status;
-        best_result.solved = node.metrics.status.unmatched == 0;
+    const bool solved = node.metrics.status.unmatched == 0;
+    if (best_result.solved) {
+        // Once an answer exists only a shorter one replaces it.
+        if (!solved || node.operations.size() >= best_result.operations.size()) {
+            return;
+        }
+    } else if (!solved && score <= best_score) {
+        return;
+    }
+
+    best_score = score;
+    best_result.operations = node.operations;
+    best_result.status = node.metrics.status;
+    best_result.solved = solved;
+    // Score-only changes are not recorded; a point is a new length, unmatched count or the first answer.
+    record_improvement(best_result);
+    if (solved && config_.on_solution) {
+        config_.on_solution(best_result.operations);
     }
 }
 
-BeamStackSearchSolver::SearchLimits BeamStackSearchSolver::derive_limits(std::size_t board_size) const {
+template <typename Evaluator, typename CandidateGenerator, typename Selector>
+void BasicBeamStackSearchSolver<Evaluator, CandidateGenerator, Selector>::record_improvement(
+    BeamStackSearchResult& result) const {
+    auto& improvements = result.stats.improvements;
+    if (improvements.empty() || improvements.back().operations != result.operations.size() ||
+        improvements.back().unmatched != result.status.unmatched || improvements.back().solved != result.solved) {
+        improvements.push_back({solve_timer_ != nullptr ? solve_timer_->elapsed_ms() : 0.0, result.operations.size(),
+                                result.status.unmatched, result.solved});
+    }
+}
+
+template <typename Evaluator, typename CandidateGenerator, typename Selector>
+auto BasicBeamStackSearchSolver<Evaluator, CandidateGenerator, Selector>::derive_limits(
+    std::size_t board_size) const -> SearchLimits {
     SearchLimits limits{};
 
     const double normalized = std::max(1.0, static_cast<double>(board_size) / 8.0);
@@ -159,12 +368,438 @@ BeamStackSearchSolver::SearchLimits BeamStackSearchSolver::derive_limits(std::si
     return limits;
 }
 
-BeamStackSearchSolver::IterationOutcome BeamStackSearchSolver::run_search_iteration(const Node& root,
-                                                                                   const SearchLimits& limits,
-                                                                                   Timer& timer,
-                                                                                   BeamStackSearchResult& result,
-                                                                                   double& best_score) const {
-    IterationOutcome outcome;
+template <typename Evaluator, typename CandidateGenerator, typename Selector>
+SolveProgress BasicBeamStackSearchSolver<Evaluator, CandidateGenerator, Selector>::progress(
+    SolvePhase phase, const BeamStackSearchResult& result, const Timer& timer) const {
+    SolveProgress step;
+    step.phase = phase;
+    step.elapsed_ms = timer.elapsed_ms();
+    step.explored_nodes = result.explored_nodes;
+    step.operations = result.operations.size();
+    step.unmatched = result.status.unmatched;
+    step.solved = result.solved;
+    return step;
+}
+
+template <typename Evaluator, typename CandidateGenerator, typename Selector>
+bool BasicBeamStackSearchSolver<Evaluator, CandidateGenerator, Selector>::out_of_time(
+    const Timer& timer) const noexcept {
+    return (config_.cancel_flag != nullptr && config_.cancel_flag->load(std::memory_order_relaxed)) ||
+           (config_.time_limit_ms > 0.0 && timer.elapsed_ms() > config_.time_limit_ms);
+}
+
+template <typename Evaluator, typename CandidateGenerator, typename Selector>
+std::size_t BasicBeamStackSearchSolver<Evaluator, CandidateGenerator, Selector>::effective_length_bound(
+    const SearchLimits& limits) const noexcept {
+    std::size_t bound = limits.length_bound;
+    if (config_.shared_length_bound != nullptr) {
+        const auto shared = config_.shared_length_bound->load(std::memory_order_relaxed);
+        if (shared > 0 && (bound == 0 || shared < bound)) {
+            bound = shared;
+        }
+    }
+    return bound;
+}
+
+template <typename Evaluator, typename CandidateGenerator, typename Selector>
+std::size_t BasicBeamStackSearchSolver<Evaluator, CandidateGenerator, Selector>::child_limit(
+    const Node& parent, const SearchLimits& limits, std::size_t children) const noexcept {
+    const std::size_t node_child_limit = limits.max_children_per_node;
+    if (node_child_limit == 0 || children <= node_child_limit) {
+        return children;
+    }
+    const auto unmatched = parent.metrics.status.unmatched;
+    const std::size_t adaptive_bonus = unmatched * 2 + std::max<std::size_t>(1, limits.beam_width / 8);
+    const std::size_t max_cap = limits.beam_width > 0 ? (limits.beam_width * 3) / 2 + 32 : children;
+    return std::min<std::size_t>({children, node_child_limit + adaptive_bonus, max_cap});
+}
+
+template <typename Evaluator, typename CandidateGenerator, typename Selector>
+void BasicBeamStackSearchSolver<Evaluator, CandidateGenerator, Selector>::keep_best_children(
+    const Node& parent, const SearchLimits& limits, std::vector<Node>& children) const {
+    const auto limit = child_limit(parent, limits, children.size());
+    if (limit < children.size()) {
+        Selector::keep_best(children, limit);
+    }
+}
+
+template <typename Evaluator, typename CandidateGenerator, typename Selector>
+auto BasicBeamStackSearchSolver<Evaluator, CandidateGenerator, Selector>::screen_for(
+    const Node& parent, const SearchLimits& limits, std::size_t candidates,
+    const std::optional<PairIndex>& index) const -> ChildScreen {
+    ChildScreen screen;
+    // The bound assumes a score that rises with matched and one-rotation pairs and falls with unmatched pairs and
+    // distances, and the bandit learns from every child.
+    if (!config_.early_rejection || config_.one_rotation_weight < 0.0 || bandit_ != nullptr ||
+        config_.match_weight < 0.0 || config_.unmatched_penalty < 0.0 || config_.total_distance_penalty < 0.0 ||
+        config_.max_distance_penalty < 0.0) {
+        return screen;
+    }
+    screen.enabled = true;
+    const auto keep = child_limit(parent, limits, candidates);
+    if (keep < candidates) {
+        screen.keep = keep;
+        screen.kept.reserve(keep + 1);
+    }
+
+    const auto& field = parent.field;
+    const auto size = field.size();
+    PairMetrics scanned;
+    const auto* mask = &parent.metrics.unmatched_mask;
+    if (mask->size() != field.cell_count()) {
+        scanned = field.evaluate_pair_metrics();
+        mask = &scanned.unmatched_mask;
+    }
+    const std::size_t stride = size + 1;
+    screen.prefix.assign(stride * stride, 0);
+    for (std::size_t y = 0; y < size; ++y) {
+        std::size_t row = 0;
+        for (std::size_t x = 0; x < size; ++x) {
+            row += (*mask)[y * size + x] != 0 ? 1U : 0U;
+            screen.prefix[(y + 1) * stride + x + 1] = screen.prefix[y * stride + x + 1] + row;
+        }
+    }
+
+    if (index) {
+        screen.parent_pairs = &*index;
+    } else {
+        screen.own_index.emplace(field);
+    }
+    return screen;
+}
+
+template <typename Evaluator, typename CandidateGenerator, typename Selector>
+bool BasicBeamStackSearchSolver<Evaluator, CandidateGenerator, Selector>::screen_out(
+    ChildScreen& screen, const Node& parent, const Operation& op, const PairMetrics* best_unsolved) const {
+    screen.exact.reset();
+    if (!screen.enabled) {
+        return false;
+    }
+    double threshold = screen.floor;
+    if (screen.keep > 0 && screen.kept.size() >= screen.keep) {
+        threshold = std::max(threshold, screen.kept.front());
+    }
+    if (threshold == std::numeric_limits<double>::lowest()) {
+        return false;
+    }
+    const auto& before = parent.metrics;
+    const auto depth = parent.depth + 1;
+    const auto length = parent.operations.size() + 1;
+
+    // Stage one: every pair the rotation completes has an unmatched cell under the window, and no unmatched cell
+    // gets more than 2k - 1 closer to its partner (2(k - 1) by moving, one more by leaving the distance count).
+    const std::size_t stride = parent.field.size() + 1;
+    const auto& prefix = screen.prefix;
+    const std::size_t x1 = op.x + op.size;
+    const std::size_t y1 = op.y + op.size;
+    const std::size_t under = prefix[y1 * stride + x1] - prefix[op.y * stride + x1] - prefix[y1 * stride + op.x] +
+                              prefix[op.y * stride + op.x];
+    const auto completed = std::min(under, before.status.unmatched);
+    // Only the at most k^2 pairs with a cell in the window change, so at most that many become one-rotation pairs.
+    const auto one_rotation_bound = parent.field.one_rotation_pairs() + op.size * op.size;
+    if (completed < before.status.unmatched) {
+        PairMetrics optimistic;
+        optimistic.status.matched = before.status.matched + completed;
+        optimistic.status.unmatched = before.status.unmatched - completed;
+        const auto closer = under * (2 * op.size - 1);
+        optimistic.total_unmatched_distance =
+            before.total_unmatched_distance > closer ? before.total_unmatched_distance - closer : 0;
+        optimistic.one_rotation_pairs = one_rotation_bound;
+        if (!beats(optimistic, best_unsolved) &&
+            Evaluator::score(config_, optimistic, depth, length) + kMaxJitter < threshold) {
+            ++screen.bound_rejections;
+            return true;
+        }
+    }
+
+    // Stage two: the exact metrics, still without copying the board.
+    thread_local PairIndex::Scratch scratch;
+    const auto& pairs = screen.parent_pairs != nullptr ? *screen.parent_pairs : *screen.own_index;
+    auto exact = pairs.metrics_after(op, scratch);
+    exact.one_rotation_pairs = std::min(one_rotation_bound, exact.status.unmatched);  // bounded until the board exists
+    if (exact.status.unmatched > 0 && !beats(exact, best_unsolved) &&
+        Evaluator::score(config_, exact, depth, length) + kMaxJitter < threshold) {
+        ++screen.delta_rejections;
+        return true;
+    }
+    screen.exact = std::move(exact);  // the caller scores the child from these instead of computing them again
+    return false;
+}
+
+template <typename Evaluator, typename CandidateGenerator, typename Selector>
+void BasicBeamStackSearchSolver<Evaluator, CandidateGenerator, Selector>::screen_keep(ChildScreen& screen,
+                                                                                      double score) {
+    if (screen.keep == 0) {
+        return;
+    }
+    screen.kept.push_back(score);
+    std::push_heap(screen.kept.begin(), screen.kept.end(), std::greater<>());
+    if (screen.kept.size() > screen.keep) {
+        std::pop_heap(screen.kept.begin(), screen.kept.end(), std::greater<>());
+        screen.kept.pop_back();
+    }
+}
+
+template <typename Evaluator, typename CandidateGenerator, typename Selector>
+auto BasicBeamStackSearchSolver<Evaluator, CandidateGenerator, Selector>::expand_layer(
+    const std::vector<Node>& layer, std::size_t begin, std::size_t end, const SearchLimits& limits,
+    std::size_t beam_width, const std::unordered_set<std::uint64_t>* visited, double floor,
+    const PairMetrics* best_unsolved, const Timer& timer) const -> LayerExpansion {
+    // The beam_width-th best distinct child a worker has kept is a lower bound on the layer's worst survivor, since
+    // the layer keeps the best beam_width of a superset of them.
+    struct WorkerState {
+        Random random;
+        std::vector<double> top;                 // min-heap of the best beam_width kept child scores
+        std::unordered_set<std::uint64_t> kept;  // hashes behind `top`, when duplicates are dropped
+    };
+    auto& pool = *config_.thread_pool;
+    WorkerLocal<WorkerState> states(pool);
+    for (auto& state : states.all()) {
+        state.random = Random(random_.next_int<std::uint64_t>(0, std::numeric_limits<std::uint64_t>::max()));
+        state.top.reserve(beam_width + 1);
+    }
+
+    LayerExpansion expansion;
+    expansion.children.resize(end - begin);
+    expansion.discarded.assign(end - begin, 0);
+    std::atomic<std::size_t> bound_rejections{0};
+    std::atomic<std::size_t> delta_rejections{0};
+    std::atomic<std::size_t> duplicate_hits{0};
+    pool.parallel_for(0, end - begin, 1, [&](std::size_t index) {
+        const auto& node = layer[begin + index];
+        if (out_of_time(timer)) {
+            return;
+        }
+        if ((limits.max_depth > 0 && node.depth >= limits.max_depth) ||
+            (limits.length_bound > 0 && node.operations.size() + 1 >= limits.length_bound)) {
+            return;
+        }
+
+        auto& state = states.local();
+        auto& children = expansion.children[index];
+        const auto candidate_ops = generate_operations(node.field, node.operations, node.metrics);
+        const auto parent_pairs = parent_index(node.field);
+        auto screen = screen_for(node, limits, candidate_ops.size(), parent_pairs);
+        screen.floor = floor;
+        if (beam_width > 0 && state.top.size() >= beam_width) {
+            screen.floor = std::max(screen.floor, state.top.front());
+        }
+        std::unordered_set<std::uint64_t> seen;
+        std::size_t duplicates = 0;
+        children.reserve(candidate_ops.size());
+        for (const auto& op : candidate_ops) {
+            if (screen_out(screen, node, op, best_unsolved)) {
+                continue;
+            }
+            Node child;
+            child.field = node.field;
+            child.field.apply(op);
+            if (visited != nullptr) {
+                const auto hash = state_hash(child.field);
+                if (visited->contains(hash) || !seen.insert(hash).second) {
+                    ++duplicates;
+                    continue;
+                }
+            }
+            child.operations = node.operations;
+            child.operations.push_back(op);
+            child.depth = node.depth + 1;
+            child.metrics = child_metrics(child.field, node.metrics, op, parent_pairs, screen);
+            child.score = evaluate(child, state.random);
+            screen_keep(screen, child.score);
+            children.push_back(std::move(child));
+        }
+        record_rotation_rewards(node, children);
+        // Trim before the merge so a layer never holds every candidate of every parent at once.
+        const auto generated = children.size();
+        keep_best_children(node, limits, children);
+        for (const auto& child : children) {
+            if (beam_width == 0 || (visited != nullptr && !state.kept.insert(state_hash(child.field)).second)) {
+                continue;
+            }
+            state.top.push_back(child.score);
+            std::push_heap(state.top.begin(), state.top.end(), std::greater<>());
+            if (state.top.size() > beam_width) {
+                std::pop_heap(state.top.begin(), state.top.end(), std::greater<>());
+                state.top.pop_back();
+            }
+        }
+        expansion.discarded[index] =
+            generated - children.size() + screen.bound_rejections + screen.delta_rejections;
+        bound_rejections.fetch_add(screen.bound_rejections, std::memory_order_relaxed);
+        delta_rejections.fetch_add(screen.delta_rejections, std::memory_order_relaxed);
+        duplicate_hits.fetch_add(duplicates, std::memory_order_relaxed);
+    });
+    expansion.bound_rejections = bound_rejections.load();
+    expansion.delta_rejections = delta_rejections.load();
+    expansion.duplicate_hits = duplicate_hits.load();
+    return expansion;
+}
+
+template <typename Evaluator, typename CandidateGenerator, typename Selector>
+auto BasicBeamStackSearchSolver<Evaluator, CandidateGenerator, Selector>::pipeline_layer(
+    const std::vector<Node>& layer, const SearchLimits& limits, std::size_t beam_width, StripedHashSet* visited,
+    const Timer& timer, BeamStackSearchResult& result, double& best_score, IterationOutcome& outcome) const
+    -> PipelinedLayer {
+    // Everything a task touches lives in its worker's slot; only solved children and the shared visited set are
+    // synchronised, and the single-threaded merge at the end sees at most beam_width nodes per worker.
+    struct WorkerState {
+        Random random;
+        std::vector<Node> top;  // min-heap on score, at most beam_width nodes
+        Node best_unsolved;
+        bool has_best_unsolved = false;
+    };
+    auto& pool = *config_.thread_pool;
+    WorkerLocal<WorkerState> states(pool);
+    for (auto& state : states.all()) {
+        state.random = Random(random_.next_int<std::uint64_t>(0, std::numeric_limits<std::uint64_t>::max()));
+        state.top.reserve(beam_width + 1);
+    }
+    const auto heap_order = [](const Node& a, const Node& b) { return a.score > b.score; };
+
+    PipelinedLayer out;
+    std::atomic<bool> stop{false};
+    std::atomic<bool> limit_hit{false};
+    std::atomic<std::size_t> explored{result.explored_nodes};
+    std::atomic<std::size_t> duplicate_hits{0};
+    std::atomic<std::size_t> duplicate_misses{0};
+    std::atomic<std::size_t> bound_rejections{0};
+    std::atomic<std::size_t> delta_rejections{0};
+    std::mutex solved_mutex;
+
+    pool.parallel_for(0, layer.size(), 1, [&](std::size_t index) {
+        if (stop.load(std::memory_order_relaxed)) {
+            return;
+        }
+        if (out_of_time(timer) ||
+            (limits.max_nodes > 0 && explored.load(std::memory_order_relaxed) >= limits.max_nodes)) {
+            limit_hit.store(true, std::memory_order_relaxed);
+            stop.store(true, std::memory_order_relaxed);
+            return;
+        }
+        const auto& node = layer[index];
+        if ((limits.max_depth > 0 && node.depth >= limits.max_depth) ||
+            (limits.length_bound > 0 && node.operations.size() + 1 >= limits.length_bound)) {
+            return;
+        }
+
+        auto& state = states.local();
+        std::vector<Node> children;
+        const auto candidate_ops = generate_operations(node.field, node.operations, node.metrics);
+        const auto parent_pairs = parent_index(node.field);
+        auto screen = screen_for(node, limits, candidate_ops.size(), parent_pairs);
+        if (state.top.size() >= beam_width) {
+            screen.floor = state.top.front().score;  // children are dropped below it after the trim anyway
+        }
+        // The next root is the best unsolved child of this worker or of an earlier layer, so only a child that could
+        // beat both is kept regardless of the floor.
+        const PairMetrics* best_unsolved = outcome.has_best_unsolved ? &outcome.best_unsolved.metrics : nullptr;
+        if (state.has_best_unsolved && beats(state.best_unsolved.metrics, best_unsolved)) {
+            best_unsolved = &state.best_unsolved.metrics;
+        }
+        children.reserve(candidate_ops.size());
+        for (const auto& op : candidate_ops) {
+            if (screen_out(screen, node, op, best_unsolved)) {
+                continue;
+            }
+            Node child;
+            child.field = node.field;
+            child.field.apply(op);
+            child.operations = node.operations;
+            child.operations.push_back(op);
+            child.depth = node.depth + 1;
+            child.metrics = child_metrics(child.field, node.metrics, op, parent_pairs, screen);
+            child.score = evaluate(child, state.random);
+            screen_keep(screen, child.score);
+            if (child.metrics.status.unmatched == 0) {
+                std::lock_guard<std::mutex> lock(solved_mutex);
+                update_best(child, result, best_score);
+                out.solved = true;
+                stop.store(true, std::memory_order_relaxed);
+                return;
+            }
+            children.push_back(std::move(child));
+        }
+        explored.fetch_add(children.size() + screen.bound_rejections + screen.delta_rejections,
+                           std::memory_order_relaxed);
+        bound_rejections.fetch_add(screen.bound_rejections, std::memory_order_relaxed);
+        delta_rejections.fetch_add(screen.delta_rejections, std::memory_order_relaxed);
+        record_rotation_rewards(node, children);
+        keep_best_children(node, limits, children);
+
+        for (auto& child : children) {
+            // Recorded before the top-K test so the screen above never loses the next root to it.
+            if (!state.has_best_unsolved ||
+                child.metrics.status.unmatched < state.best_unsolved.metrics.status.unmatched ||
+                (child.metrics.status.unmatched == state.best_unsolved.metrics.status.unmatched &&
+                 child.metrics.total_unmatched_distance < state.best_unsolved.metrics.total_unmatched_distance)) {
+                state.best_unsolved = child;
+                state.has_best_unsolved = true;
+            }
+            // A child that cannot enter this worker's top-K cannot enter the global one either, so it is dropped
+            // before it costs a lock on the visited set.
+            if (state.top.size() >= beam_width && child.score <= state.top.front().score) {
+                continue;
+            }
+            if (visited != nullptr) {
+                if (!visited->insert(state_hash(child.field))) {
+                    duplicate_hits.fetch_add(1, std::memory_order_relaxed);
+                    continue;
+                }
+                duplicate_misses.fetch_add(1, std::memory_order_relaxed);
+            }
+            state.top.push_back(std::move(child));
+            std::push_heap(state.top.begin(), state.top.end(), heap_order);
+            if (state.top.size() > beam_width) {
+                std::pop_heap(state.top.begin(), state.top.end(), heap_order);
+                state.top.pop_back();
+            }
+        }
+    });
+
+    result.explored_nodes = explored.load();
+    result.stats.duplicate_hits += duplicate_hits.load();
+    result.stats.duplicate_misses += duplicate_misses.load();
+    result.stats.bound_rejections += bound_rejections.load();
+    result.stats.delta_rejections += delta_rejections.load();
+    out.reached_limit = limit_hit.load();
+    if (out.solved) {
+        outcome.solved = true;
+        return out;
+    }
+
+    for (auto& state : states.all()) {
+        if (state.has_best_unsolved &&
+            (!outcome.has_best_unsolved ||
+             state.best_unsolved.metrics.status.unmatched < outcome.best_unsolved.metrics.status.unmatched ||
+             (state.best_unsolved.metrics.status.unmatched == outcome.best_unsolved.metrics.status.unmatched &&
+              state.best_unsolved.metrics.total_unmatched_distance <
+                  outcome.best_unsolved.metrics.total_unmatched_distance))) {
+            outcome.best_unsolved = std::move(state.best_unsolved);
+            outcome.has_best_unsolved = true;
+        }
+        const Node* best_scored = nullptr;
+        for (const auto& node : state.top) {
+            if (best_scored == nullptr || node.score > best_scored->score) {
+                best_scored = &node;
+            }
+        }
+        if (best_scored != nullptr) {
+            update_best(*best_scored, result, best_score);
+        }
+        std::move(state.top.begin(), state.top.end(), std::back_inserter(out.next_layer));
+    }
+    if (out.next_layer.size() > beam_width) {
+        Selector::keep_best(out.next_layer, beam_width);
+    }
+    return out;
+}
+
+template <typename Evaluator, typename CandidateGenerator, typename Selector>
+Generator<SolveProgress> BasicBeamStackSearchSolver<Evaluator, CandidateGenerator, Selector>::run_search_iteration(
+    const Node& root, const SearchLimits& limits, Timer& timer, BeamStackSearchResult& result, double& best_score,
+    IterationOutcome& outcome) const {
+    outcome = IterationOutcome{};
 
     if (root.metrics.status.unmatched > 0) {
         outcome.best_unsolved = root;
@@ -177,98 +812,279 @@ BeamStackSearchSolver::IterationOutcome BeamStackSearchSolver::run_search_iterat
 
     std::unordered_set<std::uint64_t> visited;
     if (config_.use_global_hash) {
-        visited.insert(root.field.zobrist_hash());
+        visited.insert(state_hash(root.field));
     }
 
     const bool enforce_node_limit = limits.max_nodes > 0;
+    const std::size_t visited_cap = enforce_node_limit ? limits.max_nodes * 4 : 0;
     bool reached_limit = false;
 
+    MemoryBudget* const budget = config_.memory_budget;
+    MemoryCharge layer_charge(budget, MemoryComponent::Layers);
+    MemoryCharge expansion_charge(budget, MemoryComponent::Expansion);
+    MemoryCharge visited_charge(budget, MemoryComponent::VisitedSet);
+    std::size_t beam_width = limits.beam_width;  // narrowed under memory pressure
+    outcome.beam_width = beam_width;
+    std::size_t current_layer_bytes = budget != nullptr ? nodes_bytes(current_layer) : 0;
+
+    const bool pipelined = config_.pipelined_layers && config_.thread_pool != nullptr;
+    std::optional<StripedHashSet> shared_visited;
+    if (pipelined && config_.use_global_hash) {
+        shared_visited.emplace();
+        shared_visited->insert(state_hash(root.field));
+    }
+
+    auto limit_reached = [&]() {
+        if (out_of_time(timer) || (enforce_node_limit && result.explored_nodes >= limits.max_nodes)) {
+            outcome.reached_limit = true;
+            return true;
+        }
+        return false;
+    };
+
+    // Returns false for a state already seen in this iteration.
+    auto admit = [&](const Field& field) {
+        if (!config_.use_global_hash) {
+            return true;
+        }
+        const auto hash = state_hash(field);
+        if (!visited.insert(hash).second) {
+            ++result.stats.duplicate_hits;
+            return false;
+        }
+        ++result.stats.duplicate_misses;
+        if (visited_cap > 0 && visited.size() > visited_cap) {
+            visited.clear();
+            visited.insert(hash);
+            ++result.stats.visited_clears;
+        }
+        return true;
+    };
+
+    // Records a scored child; returns true when it solves the board.
+    auto accept = [&](const Node& child) {
+        update_best(child, result, best_score);
+        ++result.explored_nodes;
+        if (child.metrics.status.unmatched == 0) {
+            outcome.solved = true;
+            return true;
+        }
+        if (!outcome.has_best_unsolved ||
+            child.metrics.status.unmatched < outcome.best_unsolved.metrics.status.unmatched ||
+            (child.metrics.status.unmatched == outcome.best_unsolved.metrics.status.unmatched &&
+             child.metrics.total_unmatched_distance < outcome.best_unsolved.metrics.total_unmatched_distance)) {
+            outcome.best_unsolved = child;
+            outcome.has_best_unsolved = true;
+        }
+        return false;
+    };
+
     for (std::size_t relative_depth = 0; relative_depth < limits.max_depth && !current_layer.empty(); ++relative_depth) {
-        if (config_.time_limit_ms > 0.0 && timer.elapsed_ms() > config_.time_limit_ms) {
+        if (out_of_time(timer)) {
             outcome.reached_limit = true;
             break;
         }
 
-        std::vector<Node> next_layer;
-        next_layer.reserve(limits.beam_width * 2 + 1);
+        SearchLimits layer_limits = limits;
+        layer_limits.length_bound = effective_length_bound(limits);
+
+        // Between layers the only boards held are the layer about to be expanded, so an overrun that outlived the
+        // previous layer is answered by halving the beam and cutting that layer back to it.
+        if (budget != nullptr && budget->over_budget() && beam_width > 1) {
+            beam_width = std::max<std::size_t>(1, beam_width / 2);
+            outcome.beam_width = beam_width;
+            budget->record_beam_shrink();
+            if (current_layer.size() > beam_width) {
+                Selector::keep_best(current_layer, beam_width);
+                current_layer_bytes = nodes_bytes(current_layer);
+                layer_charge.set(current_layer_bytes);
+            }
+        }
 
-        for (const auto& node : current_layer) {
-            if (config_.time_limit_ms > 0.0 && timer.elapsed_ms() > config_.time_limit_ms) {
+        if (pipelined) {
+            if (shared_visited &&
+                ((visited_cap > 0 && shared_visited->size() > visited_cap) || (budget && budget->over_budget()))) {
+                shared_visited->clear();
+                ++result.stats.visited_clears;
+            }
+            auto layer = pipeline_layer(current_layer, layer_limits, beam_width,
+                                        shared_visited ? &*shared_visited : nullptr, timer, result, best_score, outcome);
+            if (layer.solved) {
+                goto iteration_finished;
+            }
+            if (layer.reached_limit) {
                 outcome.reached_limit = true;
-                reached_limit = true;
                 break;
             }
-            if (enforce_node_limit && result.explored_nodes >= limits.max_nodes) {
-                outcome.reached_limit = true;
+            if (layer.next_layer.empty()) {
+                break;
+            }
+            current_layer = std::move(layer.next_layer);
+            if (budget != nullptr) {
+                current_layer_bytes = nodes_bytes(current_layer);
+                layer_charge.set(current_layer_bytes);
+                visited_charge.set(shared_visited ? shared_visited->size() * kVisitedEntryBytes : 0);
+            }
+            co_yield progress(SolvePhase::Search, result, timer);
+            continue;
+        }
+
+        std::vector<Node> next_layer;
+        next_layer.reserve(beam_width * 2 + 1);
+        std::size_t next_layer_bytes = 0;
+        bool beam_shrunk = false;  // at most one halving per layer
+        // Worst node of the layer once it has been cut back to the beam: nothing below it can survive the layer.
+        double layer_floor = std::numeric_limits<double>::lowest();
+
+        // Called after each parent's children are merged while a budget is attached. The current layer is fixed for
+        // the rest of the depth, so only the layer being built and the visited set can give memory back. The layer
+        // goes first: clearing the visited set forfeits every duplicate it would catch, so that is done only when it
+        // alone ends the overrun.
+        auto relieve_pressure = [&]() {
+            visited_charge.set(visited.size() * kVisitedEntryBytes);
+            layer_charge.set(current_layer_bytes + next_layer_bytes);
+            if (!budget->over_budget()) {
+                return;
+            }
+            auto trim = [&]() {
+                if (next_layer.size() > beam_width) {
+                    Selector::keep_best(next_layer, beam_width);
+                    next_layer_bytes = nodes_bytes(next_layer);
+                    layer_charge.set(current_layer_bytes + next_layer_bytes);
+                }
+            };
+            trim();
+            if (budget->over_budget() && !beam_shrunk && beam_width > 1) {
+                beam_width = std::max<std::size_t>(1, beam_width / 2);
+                outcome.beam_width = beam_width;
+                beam_shrunk = true;
+                budget->record_beam_shrink();
+                trim();
+            }
+            if (budget->over_budget() && visited.size() > 1 &&
+                visited_charge.bytes() >= std::min(budget->used() - budget->limit(), budget->limit() / 2)) {
+                visited.clear();
+                ++result.stats.visited_clears;
+                visited_charge.set(0);
+                budget->record_eviction();
+            }
+        };
+
+        // With a pool the children of a batch of parents are built, deduplicated against earlier batches and scored
+        // concurrently up front; the pass below then only catches duplicates between parents of the batch, counts and
+        // selects them in parent order. The batch is the whole layer unless a memory limit is set, in which case it
+        // is sized to the remaining headroom.
+        const bool parallel = config_.thread_pool != nullptr && current_layer.size() > 1;
+        LayerExpansion expansion;
+        std::size_t expansion_begin = 0;
+        std::size_t expansion_end = 0;
+        std::size_t bytes_per_parent = 0;
+        auto expand_from = [&](std::size_t first) {
+            std::size_t batch = current_layer.size() - first;
+            if (budget != nullptr && budget->limit() > 0) {
+                expansion_charge.set(0);
+                const auto used = budget->used();
+                const auto headroom = budget->limit() > used ? budget->limit() - used : 0;
+                // Until one batch has been measured, each worker gets a single parent.
+                const auto affordable = bytes_per_parent > 0 ? headroom / bytes_per_parent : 0;
+                batch = std::min(batch, std::max(config_.thread_pool->size(), affordable));
+            }
+            expansion_begin = first;
+            expansion_end = first + batch;
+            expansion = expand_layer(current_layer, expansion_begin, expansion_end, layer_limits, beam_width,
+                                     config_.use_global_hash ? &visited : nullptr, layer_floor,
+                                     outcome.has_best_unsolved ? &outcome.best_unsolved.metrics : nullptr, timer);
+            result.stats.bound_rejections += expansion.bound_rejections;
+            result.stats.delta_rejections += expansion.delta_rejections;
+            result.stats.duplicate_hits += expansion.duplicate_hits;
+            if (budget != nullptr) {
+                std::size_t bytes = 0;
+                for (const auto& children : expansion.children) {
+                    bytes += nodes_bytes(children);
+                }
+                expansion_charge.set(bytes);
+                bytes_per_parent = std::max<std::size_t>(1, bytes / batch);
+            }
+        };
+
+        for (std::size_t parent = 0; parent < current_layer.size(); ++parent) {
+            const auto& node = current_layer[parent];
+            if (limit_reached()) {
                 reached_limit = true;
                 break;
             }
             if (limits.max_depth > 0 && node.depth >= limits.max_depth) {
                 continue;
             }
-
-            auto candidate_ops = generate_operations(node.field, node.operations, node.metrics);
-            if (candidate_ops.empty()) {
-                continue;
+            if (layer_limits.length_bound > 0 && node.operations.size() + 1 >= layer_limits.length_bound) {
+                continue;  // every child would be at least as long as the known answer
             }
 
             std::vector<Node> children;
-            children.reserve(candidate_ops.size());
-
-            for (const auto& op : candidate_ops) {
-                if (config_.time_limit_ms > 0.0 && timer.elapsed_ms() > config_.time_limit_ms) {
-                    outcome.reached_limit = true;
-                    reached_limit = true;
-                    break;
-                }
-                if (enforce_node_limit && result.explored_nodes >= limits.max_nodes) {
-                    outcome.reached_limit = true;
-                    reached_limit = true;
-                    break;
+            ChildScreen screen;
+            if (parallel) {
+                if (parent >= expansion_end) {
+                    expand_from(parent);
                 }
-
-                Node child;
-                child.field = node.field;
-                child.field.apply(op);
-                if (config_.use_global_hash) {
-                    const auto hash = child.field.zobrist_hash();
-                    if (visited.find(hash) != visited.end()) {
+                const auto slot = parent - expansion_begin;
+                result.explored_nodes += expansion.discarded[slot];
+                children.reserve(expansion.children[slot].size());
+                for (auto& child : expansion.children[slot]) {
+                    if (limit_reached()) {
+                        reached_limit = true;
+                        break;
+                    }
+                    if (!admit(child.field)) {
                         continue;
                     }
-                    visited.insert(hash);
-                    const std::size_t visited_cap = enforce_node_limit ? limits.max_nodes * 4 : 0;
-                    if (visited_cap > 0 && visited.size() > visited_cap) {
-                        visited.clear();
-                        visited.insert(hash);
+                    if (accept(child)) {
+                        children.push_back(std::move(child));
+                        goto iteration_finished;
                     }
+                    children.push_back(std::move(child));
                 }
+            } else {
+                const auto candidate_ops = generate_operations(node.field, node.operations, node.metrics);
+                const auto parent_pairs = parent_index(node.field);
+                screen = screen_for(node, limits, candidate_ops.size(), parent_pairs);
+                screen.floor = layer_floor;
+                children.reserve(candidate_ops.size());
+                for (const auto& op : candidate_ops) {
+                    if (limit_reached()) {
+                        reached_limit = true;
+                        break;
+                    }
+                    // Every child is a candidate for the next root, so one that would become it is never screened.
+                    if (screen_out(screen, node, op,
+                                   outcome.has_best_unsolved ? &outcome.best_unsolved.metrics : nullptr)) {
+                        ++result.explored_nodes;
+                        continue;
+                    }
 
-                child.operations = node.operations;
-                child.operations.push_back(op);
-                child.depth = node.depth + 1;
-                child.metrics = child.field.evaluate_pair_metrics();
-                child.score = evaluate(child);
+                    Node child;
+                    child.field = node.field;
+                    child.field.apply(op);
+                    if (!admit(child.field)) {
+                        continue;
+                    }
 
-                update_best(child, result, best_score);
-                ++result.explored_nodes;
+                    child.operations = node.operations;
+                    child.operations.push_back(op);
+                    child.depth = node.depth + 1;
+                    child.metrics = child_metrics(child.field, node.metrics, op, parent_pairs, screen);
+                    child.score = evaluate(child);
+                    screen_keep(screen, child.score);
 
-                if (child.metrics.status.unmatched == 0) {
-                    outcome.solved = true;
+                    if (accept(child)) {
+                        children.push_back(std::move(child));
+                        goto iteration_finished;
+                    }
                     children.push_back(std::move(child));
-                    goto iteration_finished;
-                }
-
-                if (!outcome.has_best_unsolved ||
-                    child.metrics.status.unmatched < outcome.best_unsolved.metrics.status.unmatched ||
-                    (child.metrics.status.unmatched == outcome.best_unsolved.metrics.status.unmatched &&
-                     child.metrics.total_unmatched_distance < outcome.best_unsolved.metrics.total_unmatched_distance)) {
-                    outcome.best_unsolved = child;
-                    outcome.has_best_unsolved = true;
                 }
-
-                children.push_back(std::move(child));
             }
 
+            result.stats.bound_rejections += screen.bound_rejections;
+            result.stats.delta_rejections += screen.delta_rejections;
             if (reached_limit) {
                 break;
             }
@@ -277,20 +1093,10 @@ BeamStackSearchSolver::IterationOutcome BeamStackSearchSolver::run_search_iterat
                 continue;
             }
 
-            if (!children.empty()) {
-                std::size_t node_child_limit = limits.max_children_per_node;
-                if (node_child_limit > 0 && children.size() > node_child_limit) {
-                    const auto unmatched = node.metrics.status.unmatched;
-                    const std::size_t adaptive_bonus = unmatched * 2 + std::max<std::size_t>(1, limits.beam_width / 8);
-                    const std::size_t max_cap = limits.beam_width > 0 ? (limits.beam_width * 3) / 2 + 32 : children.size();
-                    node_child_limit = std::min<std::size_t>({children.size(), node_child_limit + adaptive_bonus, max_cap});
-
-                    std::partial_sort(children.begin(),
-                                      children.begin() + static_cast<std::ptrdiff_t>(node_child_limit), children.end(),
-                                      [](const Node& a, const Node& b) { return a.score > b.score; });
-                    children.resize(node_child_limit);
-                }
+            if (!parallel) {
+                record_rotation_rewards(node, children);
             }
+            keep_best_children(node, limits, children);
 
             for (auto& child : children) {
                 if (child.metrics.status.unmatched == 0) {
@@ -299,9 +1105,29 @@ BeamStackSearchSolver::IterationOutcome BeamStackSearchSolver::run_search_iterat
                     next_layer.push_back(std::move(child));
                     goto iteration_finished;
                 }
+                if (budget != nullptr) {
+                    next_layer_bytes += node_bytes(child);
+                }
                 next_layer.push_back(std::move(child));
             }
+            // Only the best beam_width of the layer survive it, so cutting back to them whenever twice as many have
+            // gathered selects the same nodes while holding a bounded number of boards.
+            if (next_layer.size() > 2 * beam_width) {
+                Selector::keep_best(next_layer, beam_width);
+                if (budget != nullptr) {
+                    next_layer_bytes = nodes_bytes(next_layer);
+                }
+                if (config_.early_rejection) {
+                    layer_floor = std::min_element(next_layer.begin(), next_layer.end(),
+                                                   [](const Node& a, const Node& b) { return a.score < b.score; })
+                                      ->score;
+                }
+            }
+            if (budget != nullptr) {
+                relieve_pressure();
+            }
         }
+        expansion_charge.set(0);
 
         if (reached_limit) {
             break;
@@ -311,22 +1137,24 @@ BeamStackSearchSolver::IterationOutcome BeamStackSearchSolver::run_search_iterat
             break;
         }
 
-        if (next_layer.size() > limits.beam_width) {
-            std::partial_sort(next_layer.begin(),
-                              next_layer.begin() + static_cast<std::ptrdiff_t>(limits.beam_width), next_layer.end(),
-                              [](const Node& a, const Node& b) { return a.score > b.score; });
-            next_layer.resize(limits.beam_width);
+        if (next_layer.size() > beam_width) {
+            Selector::keep_best(next_layer, beam_width);
+            next_layer_bytes = budget != nullptr ? nodes_bytes(next_layer) : 0;
         }
 
         current_layer = std::move(next_layer);
+        current_layer_bytes = next_layer_bytes;
+        layer_charge.set(current_layer_bytes);
+        co_yield progress(SolvePhase::Search, result, timer);
     }
 
 iteration_finished:
-    return outcome;
+    co_return;
 }
 
-bool BeamStackSearchSolver::apply_shake(Node& node, BeamStackSearchResult& result, Timer& timer,
-                                        double& best_score) const {
+template <typename Evaluator, typename CandidateGenerator, typename Selector>
+bool BasicBeamStackSearchSolver<Evaluator, CandidateGenerator, Selector>::apply_shake(
+    Node& node, BeamStackSearchResult& result, Timer& timer, double& best_score) const {
     if (config_.shake_attempts == 0 || config_.shake_max_length == 0) {
         return false;
     }
@@ -392,14 +1220,178 @@ bool BeamStackSearchSolver::apply_shake(Node& node, BeamStackSearchResult& resul
     return false;
 }
 
-bool BeamStackSearchSolver::greedy_refinement(const Problem& problem, BeamStackSearchResult& result, Timer& timer,
-                                              double& best_score) const {
-    if (result.solved) {
+template <typename Evaluator, typename CandidateGenerator, typename Selector>
+auto BasicBeamStackSearchSolver<Evaluator, CandidateGenerator, Selector>::run_shake_chain(
+    const Node& root, Random& random, PairIndex::Scratch& scratch, const Timer& timer) const -> ShakeChain {
+    const auto shaking_too_long = [&]() {
+        return out_of_time(timer) ||
+               (config_.time_limit_ms > 0.0 && timer.elapsed_ms() > config_.time_limit_ms * config_.shake_time_ratio);
+    };
+    const auto score_of = [&](const PairMetrics& metrics, std::size_t path_length) {
+        return evaluate(metrics, root.depth + path_length, root.operations.size() + path_length, random);
+    };
+    const auto history_of = [&](const ShakeState& state) -> const std::vector<Operation>& {
+        return state.path.empty() ? root.operations : state.path;
+    };
+
+    ShakeChain chain;
+    ShakeState walk{root.field, {}, root.metrics, root.score};
+    const auto steps = random.next_int<std::size_t>(1, std::max<std::size_t>(1, config_.shake_max_length));
+    for (std::size_t step = 0; step < steps && walk.metrics.status.unmatched > 0 && !shaking_too_long(); ++step) {
+        const auto candidate_ops = generate_operations(walk.field, history_of(walk), walk.metrics);
+        if (candidate_ops.empty()) {
+            break;
+        }
+        const auto sample = std::min<std::size_t>(candidate_ops.size(), 64);
+        const auto& op = candidate_ops[random.next_int<std::size_t>(0, sample - 1)];
+        walk.field.apply(op);
+        walk.path.push_back(op);
+        walk.metrics = walk.field.evaluate_pair_metrics();
+        ++chain.explored;
+    }
+    if (walk.path.empty()) {
+        return chain;
+    }
+    walk.score = score_of(walk.metrics, walk.path.size());
+    chain.moved = true;
+
+    // Short beam from the end of the walk. Children are ranked from the pair index of their parent; only the kept
+    // ones get a board of their own. The index knows nothing of one-rotation pairs, so when they are weighed each
+    // child is also applied to a scratch board to count them.
+    struct Candidate {
+        double score;
+        std::size_t parent;
+        Operation op;
+        PairMetrics metrics;
+    };
+    std::vector<ShakeState> layer{walk};
+    chain.best = std::move(walk);
+    std::vector<Candidate> candidates;
+    const bool count_one_rotation = config_.one_rotation_weight != 0.0;
+    Field probe;
+    for (std::size_t depth = 0; depth < config_.shake_beam_depth && chain.best.metrics.status.unmatched > 0; ++depth) {
+        if (shaking_too_long()) {
+            break;
+        }
+        candidates.clear();
+        for (std::size_t parent = 0; parent < layer.size(); ++parent) {
+            const auto& state = layer[parent];
+            const PairIndex index(state.field);
+            for (const auto& op : generate_operations(state.field, history_of(state), state.metrics)) {
+                auto metrics = index.metrics_after(op, scratch);
+                if (count_one_rotation) {
+                    probe = state.field;
+                    probe.apply(op);
+                    metrics.one_rotation_pairs = probe.one_rotation_pairs();
+                }
+                const auto score = score_of(metrics, state.path.size() + 1);
+                candidates.push_back(Candidate{score, parent, op, std::move(metrics)});
+            }
+        }
+        chain.explored += candidates.size();
+        if (candidates.empty()) {
+            break;
+        }
+        const auto keep = std::min(candidates.size(), std::max<std::size_t>(1, config_.shake_beam_width));
+        std::partial_sort(candidates.begin(), candidates.begin() + static_cast<std::ptrdiff_t>(keep), candidates.end(),
+                          [](const Candidate& a, const Candidate& b) { return a.score > b.score; });
+
+        std::vector<ShakeState> next_layer;
+        next_layer.reserve(keep);
+        for (std::size_t i = 0; i < keep; ++i) {
+            const auto& candidate = candidates[i];
+            const auto& parent = layer[candidate.parent];
+            ShakeState child{parent.field, parent.path, {}, candidate.score};
+            child.field.apply(candidate.op);
+            child.path.push_back(candidate.op);
+            child.metrics = child.field.evaluate_pair_metrics();
+            next_layer.push_back(std::move(child));
+        }
+        if (next_layer.front().score > chain.best.score) {
+            chain.best = next_layer.front();
+        }
+        layer = std::move(next_layer);
+    }
+    return chain;
+}
+
+template <typename Evaluator, typename CandidateGenerator, typename Selector>
+bool BasicBeamStackSearchSolver<Evaluator, CandidateGenerator, Selector>::shake_tournament(
+    Node& node, BeamStackSearchResult& result, Timer& timer, double& best_score) const {
+    if (config_.shake_max_length == 0 || out_of_time(timer) ||
+        (config_.time_limit_ms > 0.0 && timer.elapsed_ms() > config_.time_limit_ms * config_.shake_time_ratio)) {
+        return false;
+    }
+
+    const auto count = config_.shake_tournament_size;
+    std::vector<Random> randoms;
+    randoms.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        randoms.emplace_back(random_.next_int<std::uint64_t>(0, std::numeric_limits<std::uint64_t>::max()));
+    }
+    std::vector<ShakeChain> chains(count);
+    if (config_.thread_pool != nullptr) {
+        WorkerLocal<PairIndex::Scratch> scratches(*config_.thread_pool);
+        config_.thread_pool->parallel_for(0, count, 1, [&](std::size_t i) {
+            chains[i] = run_shake_chain(node, randoms[i], scratches.local(), timer);
+        });
+    } else {
+        PairIndex::Scratch scratch;
+        for (std::size_t i = 0; i < count; ++i) {
+            chains[i] = run_shake_chain(node, randoms[i], scratch, timer);
+        }
+    }
+
+    const auto distance_of = [](const PairMetrics& metrics) {
+        return metrics.total_unmatched_distance + metrics.max_unmatched_distance;
+    };
+    const ShakeChain* winner = nullptr;
+    for (const auto& chain : chains) {
+        result.explored_nodes += chain.explored;
+        if (!chain.moved) {
+            continue;
+        }
+        const auto& metrics = chain.best.metrics;
+        if (winner == nullptr || metrics.status.unmatched < winner->best.metrics.status.unmatched ||
+            (metrics.status.unmatched == winner->best.metrics.status.unmatched &&
+             distance_of(metrics) < distance_of(winner->best.metrics))) {
+            winner = &chain;
+        }
+    }
+    if (winner == nullptr) {
+        return false;
+    }
+
+    const auto new_unmatched = winner->best.metrics.status.unmatched;
+    const auto original_unmatched = node.metrics.status.unmatched;
+    const bool strict_improvement =
+        new_unmatched < original_unmatched ||
+        (new_unmatched == original_unmatched && distance_of(winner->best.metrics) < distance_of(node.metrics));
+    const bool equal_accept = new_unmatched == original_unmatched &&
+                              distance_of(winner->best.metrics) == distance_of(node.metrics) &&
+                              random_.next_real(0.0, 1.0) < config_.shake_accept_equal_probability;
+    if (!strict_improvement && !equal_accept) {
         return false;
     }
 
+    node.field = winner->best.field;
+    node.operations.insert(node.operations.end(), winner->best.path.begin(), winner->best.path.end());
+    node.depth = node.operations.size();
+    node.metrics = winner->best.metrics;
+    node.score = evaluate(node);
+    update_best(node, result, best_score);
+    return true;
+}
+
+template <typename Evaluator, typename CandidateGenerator, typename Selector>
+Generator<SolveProgress> BasicBeamStackSearchSolver<Evaluator, CandidateGenerator, Selector>::greedy_refinement(
+    const Problem& problem, BeamStackSearchResult& result, Timer& timer, double& best_score) const {
+    if (result.solved) {
+        co_return;
+    }
+
     Node state;
-    state.field = problem.make_field();
+    state.field = start_field(problem);
     state.operations = result.operations;
     for (const auto& op : state.operations) {
         state.field.apply(op);
@@ -413,7 +1405,7 @@ bool BeamStackSearchSolver::greedy_refinement(const Problem& problem, BeamStackS
     if (state.metrics.status.unmatched == 0) {
         result.solved = true;
         result.status = state.metrics.status;
-        return true;
+        co_return;
     }
 
     PairMetrics best_metrics = state.metrics;
@@ -424,8 +1416,22 @@ bool BeamStackSearchSolver::greedy_refinement(const Problem& problem, BeamStackS
     const std::size_t sample_limit = std::max<std::size_t>(1, config_.refinement_sample);
     const double refinement_start_ms = timer.elapsed_ms();
 
+    // Candidates are scored from the pair index of the current state, so a scan copies neither boards nor
+    // operation lists; only the accepted move is applied. The winner is the lowest (unmatched, total distance,
+    // candidate index), which does not depend on how the scan was split across workers.
+    struct Scan {
+        PairIndex::Scratch scratch;
+        std::size_t pick = kNoCandidate;
+        PairMetrics metrics;
+    };
+    std::optional<WorkerLocal<Scan>> worker_scans;
+    if (config_.thread_pool != nullptr) {
+        worker_scans.emplace(*config_.thread_pool);
+    }
+    Scan serial_scan;
+
     for (std::size_t attempt = 0; attempt < max_attempts; ++attempt) {
-        if ((config_.time_limit_ms > 0.0 && timer.elapsed_ms() > config_.time_limit_ms) ||
+        if (out_of_time(timer) ||
             (config_.refinement_time_budget_ms > 0.0 &&
              timer.elapsed_ms() - refinement_start_ms > config_.refinement_time_budget_ms)) {
             break;
@@ -437,52 +1443,71 @@ bool BeamStackSearchSolver::greedy_refinement(const Problem& problem, BeamStackS
         }
 
         const std::size_t inspect = std::min<std::size_t>(candidate_ops.size(), sample_limit);
-        Node best_child;
-        bool has_child = false;
-
-        for (std::size_t idx = 0; idx < inspect; ++idx) {
-            const auto& op = candidate_ops[idx];
-
-            Node child;
-            child.field = state.field;
-            child.field.apply(op);
-            child.operations = state.operations;
-            child.operations.push_back(op);
-            child.depth = child.operations.size();
-            child.metrics = child.field.evaluate_pair_metrics();
-
-            ++result.explored_nodes;
-
-            const auto child_unmatched = child.metrics.status.unmatched;
-            const auto state_unmatched = state.metrics.status.unmatched;
+        const PairIndex index(state.field);
+        const auto state_unmatched = state.metrics.status.unmatched;
+        const auto state_distance = state.metrics.total_unmatched_distance + state.metrics.max_unmatched_distance;
 
+        const auto consider = [&](Scan& scan, std::size_t idx) {
+            auto child = index.metrics_after(candidate_ops[idx], scan.scratch);
+            const auto child_unmatched = child.status.unmatched;
             if (child_unmatched > state_unmatched) {
-                continue;
+                return;
             }
-
-            const auto child_distance = child.metrics.total_unmatched_distance + child.metrics.max_unmatched_distance;
-            const auto state_distance = state.metrics.total_unmatched_distance + state.metrics.max_unmatched_distance;
-
+            const auto child_distance = child.total_unmatched_distance + child.max_unmatched_distance;
             if (child_unmatched == state_unmatched && child_distance >= state_distance) {
-                continue;
+                return;
+            }
+            if (scan.pick == kNoCandidate || child_unmatched < scan.metrics.status.unmatched ||
+                (child_unmatched == scan.metrics.status.unmatched &&
+                 (child.total_unmatched_distance < scan.metrics.total_unmatched_distance ||
+                  (child.total_unmatched_distance == scan.metrics.total_unmatched_distance && idx < scan.pick)))) {
+                scan.pick = idx;
+                scan.metrics = std::move(child);
             }
+        };
 
-            if (!has_child ||
-                child_unmatched < best_child.metrics.status.unmatched ||
-                (child_unmatched == best_child.metrics.status.unmatched &&
-                 child.metrics.total_unmatched_distance < best_child.metrics.total_unmatched_distance)) {
-                best_child = std::move(child);
-                has_child = true;
+        std::size_t pick = kNoCandidate;
+        if (worker_scans && inspect >= kParallelRefinementMin) {
+            for (auto& scan : worker_scans->all()) {
+                scan.pick = kNoCandidate;
+            }
+            auto& pool = *config_.thread_pool;
+            const auto grain = std::max(kRefinementGrain, inspect / (4 * std::max<std::size_t>(1, pool.size())));
+            pool.parallel_for(0, inspect, grain, [&](std::size_t idx) { consider(worker_scans->local(), idx); });
+            const Scan* winner = nullptr;
+            for (const auto& scan : worker_scans->all()) {
+                if (scan.pick == kNoCandidate) {
+                    continue;
+                }
+                if (winner == nullptr || scan.metrics.status.unmatched < winner->metrics.status.unmatched ||
+                    (scan.metrics.status.unmatched == winner->metrics.status.unmatched &&
+                     (scan.metrics.total_unmatched_distance < winner->metrics.total_unmatched_distance ||
+                      (scan.metrics.total_unmatched_distance == winner->metrics.total_unmatched_distance &&
+                       scan.pick < winner->pick)))) {
+                    winner = &scan;
+                }
+            }
+            if (winner != nullptr) {
+                pick = winner->pick;
+            }
+        } else {
+            serial_scan.pick = kNoCandidate;
+            for (std::size_t idx = 0; idx < inspect; ++idx) {
+                consider(serial_scan, idx);
             }
+            pick = serial_scan.pick;
         }
+        result.explored_nodes += inspect;
 
-        if (!has_child) {
+        if (pick == kNoCandidate) {
             break;
         }
 
-        best_child.score = evaluate(best_child);
-        state = std::move(best_child);
+        state.field.apply(candidate_ops[pick]);
+        state.operations.push_back(candidate_ops[pick]);
+        state.depth = state.operations.size();
         state.metrics = state.field.evaluate_pair_metrics();
+        state.score = evaluate(state);
 
         update_best(state, result, best_score);
         improved = true;
@@ -497,6 +1522,7 @@ bool BeamStackSearchSolver::greedy_refinement(const Problem& problem, BeamStackS
         if (state.metrics.status.unmatched == 0) {
             break;
         }
+        co_yield progress(SolvePhase::Refinement, result, timer);
     }
 
     if (improved) {
@@ -505,22 +1531,153 @@ bool BeamStackSearchSolver::greedy_refinement(const Problem& problem, BeamStackS
         result.solved = best_metrics.status.unmatched == 0;
         state.depth = state.operations.size();
     }
+}
+
+template <typename Evaluator, typename CandidateGenerator, typename Selector>
+bool BasicBeamStackSearchSolver<Evaluator, CandidateGenerator, Selector>::prune_operations(
+    const Problem& problem, BeamStackSearchResult& result) const {
+    if (!result.solved || result.operations.empty()) {
+        return false;
+    }
+
+    // An answer only has to end in some goal state, so any short window whose removal still does is dead weight.
+    Trajectory trajectory(problem.make_field(), result.operations);
+    bool pruned = false;
+    for (std::size_t width = kMaxPrunedWindow; width > 0; --width) {
+        for (std::size_t begin = trajectory.size(); begin-- > 0;) {
+            if (begin + width > trajectory.size()) {
+                continue;
+            }
+            if (trajectory.final_state_with_replacement(begin, begin + width, {}).is_goal_state()) {
+                trajectory.replace(begin, begin + width, {});
+                pruned = true;
+            }
+        }
+    }
+
+    if (pruned) {
+        result.operations = trajectory.operations();
+        record_improvement(result);
+        if (config_.on_solution) {
+            config_.on_solution(result.operations);
+        }
+    }
+    return pruned;
+}
+
+template <typename Evaluator, typename CandidateGenerator, typename Selector>
+Generator<SolveProgress> BasicBeamStackSearchSolver<Evaluator, CandidateGenerator, Selector>::shorten_solution(
+    const Problem& problem, const SearchLimits& base_limits, BeamStackSearchResult& result, Timer& timer,
+    double& best_score, bool& improved) const {
+    improved = false;
+    if (!result.solved || result.operations.size() < 2) {
+        co_return;
+    }
+
+    const double start_ms = timer.elapsed_ms();
+    auto budget_spent = [&]() {
+        return out_of_time(timer) || timer.elapsed_ms() - start_ms > config_.lns_time_budget_ms;
+    };
+
+    std::size_t segment_nodes = std::max<std::size_t>(1, config_.lns_segment_nodes);
+    // Re-solve the suffix after every cut point under the current length bound. A shorter answer keeps the prefix,
+    // so the root state is advanced along whatever the answer is at that moment. Sweeps that find nothing double
+    // the node cap of the next one.
+    while (!budget_spent() && result.operations.size() >= 2) {
+        bool sweep_improved = false;
+        Node root;
+        root.field = start_field(problem);
+        for (std::size_t cut = 0; cut + 1 < result.operations.size() && !budget_spent(); ++cut) {
+            root.operations.assign(result.operations.begin(),
+                                   result.operations.begin() + static_cast<std::ptrdiff_t>(cut));
+            root.depth = cut;
+            root.metrics = root_metrics(root.field);
+            root.score = evaluate(root);
+
+            SearchLimits limits = base_limits;
+            limits.length_bound = result.operations.size();
+            limits.max_depth = limits.length_bound;
+            limits.max_nodes = result.explored_nodes + segment_nodes;
+
+            const auto before = result.operations.size();
+            IterationOutcome outcome;
+            auto layers = run_search_iteration(root, limits, timer, result, best_score, outcome);
+            while (layers.next()) {
+                auto step = layers.value();
+                step.phase = SolvePhase::Shortening;
+                co_yield step;
+            }
+            sweep_improved = sweep_improved || result.operations.size() < before;
+
+            root.field.apply(result.operations[cut]);
+        }
+        improved = improved || sweep_improved;
+        if (!sweep_improved) {
+            segment_nodes *= 2;
+        }
+    }
+}
 
-    return improved;
+template <typename Evaluator, typename CandidateGenerator, typename Selector>
+BeamStackSearchResult BasicBeamStackSearchSolver<Evaluator, CandidateGenerator, Selector>::solve(
+    const Problem& problem) {
+    return solve(problem, {});
 }
 
-BeamStackSearchResult BeamStackSearchSolver::solve(const Problem& problem) {
+template <typename Evaluator, typename CandidateGenerator, typename Selector>
+BeamStackSearchResult BasicBeamStackSearchSolver<Evaluator, CandidateGenerator, Selector>::solve(
+    const Problem& problem, const std::vector<Operation>& warm_start) {
     BeamStackSearchResult result;
     Timer timer;
+    auto steps = solve_steps(problem, warm_start, timer, result);
+    while (steps.next()) {
+    }
+    return result;
+}
+
+template <typename Evaluator, typename CandidateGenerator, typename Selector>
+Generator<SolveProgress> BasicBeamStackSearchSolver<Evaluator, CandidateGenerator, Selector>::solve_steps(
+    const Problem& problem, const std::vector<Operation>& warm_start, Timer& timer, BeamStackSearchResult& result) {
+    // The solve's allocation phase is put on the resuming thread for the length of each resumption only, and what
+    // the solve left it at is picked up again next time, so the caller's phase survives every yield.
+    auto steps = run_solve(problem, warm_start, timer, result);
+    AllocationPhase phase = AllocationPhase::Search;
+    while (true) {
+        bool more = false;
+        {
+            const AllocationPhaseScope resumed(phase);
+            more = steps.next();
+            phase = current_allocation_phase();
+        }
+        if (!more) {
+            break;
+        }
+        co_yield steps.value();
+    }
+}
 
-    result.elapsed_ms = 0.0;
-    result.explored_nodes = 0;
+template <typename Evaluator, typename CandidateGenerator, typename Selector>
+Generator<SolveProgress> BasicBeamStackSearchSolver<Evaluator, CandidateGenerator, Selector>::run_solve(
+    const Problem& problem, const std::vector<Operation>& warm_start, Timer& timer, BeamStackSearchResult& result) {
+    result = BeamStackSearchResult{};
+    solve_timer_ = &timer;
+    bandit_.reset();
+    if (config_.bandit_candidate_budget > 0) {
+        std::vector<std::size_t> arms;
+        std::copy_if(config_.rotation_sizes.begin(), config_.rotation_sizes.end(), std::back_inserter(arms),
+                     [&](std::size_t k) { return k >= 2 && k <= problem.size; });
+        bandit_ = std::make_shared<RotationBandit>(std::move(arms));
+    }
+    reach_.reset();
+    if (config_.one_rotation_weight != 0.0) {
+        reach_ = std::make_shared<const RotationReach>(problem.size, config_.rotation_sizes);
+    }
 
     SearchLimits base_limits = derive_limits(problem.size);
 
     Node current_root;
-    current_root.field = problem.make_field();
-    current_root.metrics = current_root.field.evaluate_pair_metrics();
+    current_root.field = start_field(problem);
+    current_root.metrics = root_metrics(current_root.field);
     current_root.depth = 0;
     current_root.operations.clear();
     current_root.score = evaluate(current_root);
@@ -528,11 +1685,55 @@ BeamStackSearchResult BeamStackSearchSolver::solve(const Problem& problem) {
     double best_score = -1e18;
     update_best(current_root, result, best_score);
 
+    if (!warm_start.empty()) {
+        Node warm;
+        warm.field = start_field(problem);
+        for (const auto& op : warm_start) {
+            if (!warm.field.is_valid_operation(op)) {
+                throw std::invalid_argument("Warm start contains an invalid operation");
+            }
+            warm.field.apply(op);
+        }
+        warm.operations = warm_start;
+        warm.depth = warm.operations.size();
+        warm.metrics = root_metrics(warm.field);
+        warm.score = evaluate(warm);
+        update_best(warm, result, best_score);
+
+        const auto warm_unmatched = warm.metrics.status.unmatched;
+        if (warm_unmatched > 0 && (warm_unmatched < current_root.metrics.status.unmatched ||
+                                   (warm_unmatched == current_root.metrics.status.unmatched &&
+                                    warm.metrics.total_unmatched_distance <
+                                        current_root.metrics.total_unmatched_distance))) {
+            current_root = std::move(warm);
+        }
+    }
+
+    // Charges the nodes explored since the last call to `phase_nodes`.
+    std::size_t attributed_nodes = 0;
+    auto attribute_nodes = [&](std::size_t& phase_nodes) {
+        phase_nodes += result.explored_nodes - attributed_nodes;
+        attributed_nodes = result.explored_nodes;
+    };
+    auto finish = [&]() {
+        result.elapsed_ms = timer.elapsed_ms();
+        if (config_.time_limit_ms > 0.0) {
+            result.stats.overshoot_ms = std::max(0.0, result.elapsed_ms - config_.time_limit_ms);
+        }
+    };
+
+    if (current_root.metrics.status.unmatched == 0) {
+        finish();
+        co_yield progress(SolvePhase::Finished, result, timer);
+        co_return;
+    }
+
     const std::size_t max_iterations = config_.adaptive_limits ? std::max<std::size_t>(1, config_.max_iterations) : 1;
     std::size_t iteration = 0;
     std::size_t shakes_used = 0;
+    std::size_t memory_beam_cap = 0;  // narrowest beam the memory budget has forced so far; 0 when never narrowed
 
-    while ((config_.time_limit_ms <= 0.0 || timer.elapsed_ms() < config_.time_limit_ms) && iteration < max_iterations) {
+    while (!out_of_time(timer) && iteration < max_iterations) {
         SearchLimits iter_limits = base_limits;
         if (iteration > 0) {
             const double widen_factor = 1.0 + 0.45 * static_cast<double>(iteration);
@@ -544,6 +1745,9 @@ BeamStackSearchResult BeamStackSearchSolver::solve(const Problem& problem) {
             if (config_.beam_width_cap > 0) {
                 iter_limits.beam_width = std::min(iter_limits.beam_width, config_.beam_width_cap);
             }
+            if (memory_beam_cap > 0) {
+                iter_limits.beam_width = std::min(iter_limits.beam_width, memory_beam_cap);
+            }
             if (iter_limits.max_nodes > 0) {
                 iter_limits.max_nodes = static_cast<std::size_t>(std::min<double>(
                     std::numeric_limits<std::size_t>::max(),
@@ -557,10 +1761,24 @@ BeamStackSearchResult BeamStackSearchSolver::solve(const Problem& problem) {
             }
         }
 
+        iter_limits.length_bound = result.solved ? result.operations.size() : 0;
+
         update_best(current_root, result, best_score);
-        auto outcome = run_search_iteration(current_root, iter_limits, timer, result, best_score);
+        IterationOutcome outcome;
+        ++result.stats.iterations;
+        auto layers = run_search_iteration(current_root, iter_limits, timer, result, best_score, outcome);
+        while (layers.next()) {
+            attribute_nodes(result.stats.search_nodes);
+            co_yield layers.value();
+        }
+        attribute_nodes(result.stats.search_nodes);
+        if (outcome.beam_width < iter_limits.beam_width) {
+            // Widening again would only run into the same memory ceiling.
+            memory_beam_cap = outcome.beam_width;
+            iter_limits.beam_width = outcome.beam_width;
+        }
 
-        if (result.solved || outcome.solved) {
+        if (outcome.solved) {
             break;
         }
 
@@ -581,8 +1799,16 @@ BeamStackSearchResult BeamStackSearchSolver::solve(const Problem& problem) {
                                    (config_.time_limit_ms <= 0.0 ||
                                     timer.elapsed_ms() < config_.time_limit_ms * config_.shake_time_ratio);
             if (can_shake) {
+                set_allocation_phase(AllocationPhase::Shake);
                 Node shaken = current_root;
-                if (apply_shake(shaken, result, timer, best_score)) {
+                const bool shaken_ok = config_.shake_tournament_size > 1
+                                           ? shake_tournament(shaken, result, timer, best_score)
+                                           : apply_shake(shaken, result, timer, best_score);
+                attribute_nodes(result.stats.shake_nodes);
+                set_allocation_phase(AllocationPhase::Search);
+                co_yield progress(SolvePhase::Search, result, timer);
+                if (shaken_ok) {
+                    ++result.stats.shakes_accepted;
                     current_root = std::move(shaken);
                     current_root.score = evaluate(current_root);
                     base_limits = iter_limits;
@@ -606,12 +1832,41 @@ BeamStackSearchResult BeamStackSearchSolver::solve(const Problem& problem) {
         ++iteration;
     }
 
-    if (!result.solved && (config_.time_limit_ms <= 0.0 || timer.elapsed_ms() < config_.time_limit_ms)) {
-        greedy_refinement(problem, result, timer, best_score);
+    if (!result.solved && !out_of_time(timer)) {
+        co_yield progress(SolvePhase::Refinement, result, timer);
+        set_allocation_phase(AllocationPhase::Refinement);
+        auto moves = greedy_refinement(problem, result, timer, best_score);
+        while (moves.next()) {
+            attribute_nodes(result.stats.refinement_nodes);
+            co_yield moves.value();
+        }
+        attribute_nodes(result.stats.refinement_nodes);
     }
 
-    result.elapsed_ms = timer.elapsed_ms();
-    return result;
+    if (result.solved) {
+        set_allocation_phase(AllocationPhase::Shortening);
+        prune_operations(problem, result);
+        if (config_.lns_time_budget_ms > 0.0 && !out_of_time(timer)) {
+            bool shortened = false;
+            auto layers = shorten_solution(problem, base_limits, result, timer, best_score, shortened);
+            while (layers.next()) {
+                attribute_nodes(result.stats.shortening_nodes);
+                co_yield layers.value();
+            }
+            attribute_nodes(result.stats.shortening_nodes);
+            if (shortened) {
+                prune_operations(problem, result);
+            }
+        }
+    }
+
+    finish();
+    co_yield progress(SolvePhase::Finished, result, timer);
 }
 
+template class BasicBeamStackSearchSolver<WeightedEvaluator, ImpactOrderedGenerator, PartialSortSelector>;
+template class BasicBeamStackSearchSolver<DistanceEvaluator, ImpactOrderedGenerator, PartialSortSelector>;
+template class BasicBeamStackSearchSolver<WeightedEvaluator, ExhaustiveGenerator, PartialSortSelector>;
+template class BasicBeamStackSearchSolver<WeightedEvaluator, ImpactOrderedGenerator, NthElementSelector>;
+
 }  // namespace proc36
@@ -1,16 +1,31 @@
 #pragma once
 
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <unordered_set>
 #include <vector>
 
 #include "lib/field.hpp"
+#include "lib/generator.hpp"
 #include "lib/operation.hpp"
+#include "lib/pair_index.hpp"
 #include "lib/problem.hpp"
 #include "lib/random.hpp"
+#include "lib/rotation_reach.hpp"
 #include "lib/timer.hpp"
+#include "solver/rotation_bandit.hpp"
 
 namespace proc36 {
 
+class MemoryBudget;
+class StripedHashSet;
+class ThreadPool;
+
 struct BeamStackSearchConfig {
     std::size_t beam_width = 160;
     std::size_t max_depth = 64;
@@ -25,6 +40,7 @@ struct BeamStackSearchConfig {
     std::size_t max_children_per_node = 80;
     std::vector<std::size_t> rotation_sizes = {2, 3, 4, 5, 6, 7, 8, 10, 12};
     bool use_global_hash = true;
+    bool canonical_hashing = false;  // key the visited set on the rotation-invariant hash
     bool adaptive_limits = true;
     std::size_t beam_width_cap = 4096;
     std::size_t max_iterations = 11;
@@ -35,6 +51,77 @@ struct BeamStackSearchConfig {
     std::size_t shake_max_length = 10;
     double shake_time_ratio = 0.85;  // only shake while within 85% of time budget
     double shake_accept_equal_probability = 0.2;
+    // Above 1: a stalled iteration runs this many shake chains from its root (in parallel with a pool), follows each
+    // with a short beam and keeps the best chain under the same acceptance rule as a single shake.
+    std::size_t shake_tournament_size = 0;
+    std::size_t shake_beam_width = 12;
+    std::size_t shake_beam_depth = 3;
+    double lns_time_budget_ms = 0.0;   // time spent re-solving suffixes of a solved answer; 0 disables it
+    std::size_t lns_segment_nodes = 6'000;  // node cap for one suffix re-solve
+    // Above 0: generate_operations emits at most about this many candidates per state, split across rotation_sizes
+    // by a UCB1 bandit on how often each size's children improved on their parent during the solve.
+    std::size_t bandit_candidate_budget = 0;
+    // Reward per unmatched pair that one rotation of an allowed size would complete. Non-zero makes every search
+    // field keep that count up to date as it is rotated.
+    double one_rotation_weight = 0.0;
+    // Freezes edge rows and columns of the board once they are complete: beam nodes keep an active rectangle that
+    // shrinks past them, and candidates and metric scans stay inside it.
+    bool lock_completed_edges = false;
+    // Scores beam children from a pair index of their parent in O(k^2) each instead of scanning the whole board, and
+    // keeps beam nodes without the unmatched mask; the generator rebuilds it once per expanded parent.
+    bool incremental_metrics = false;
+    // Above 0: the impact-ordered generator emits at most this many windows per state, split evenly across
+    // rotation_sizes, each size keeping the windows that cover the most unmatched cells.
+    std::size_t candidate_limit = 0;
+    // Screens each parent's candidates before the board copy once it has more than it keeps: first by an upper bound
+    // on the child score from the unmatched cells under the window, then by the exact metrics from the parent's pair
+    // index. Only candidates that could still beat the worst child kept so far are copied and scored; one-rotation
+    // pairs are bounded by the parent's plus the k^2 pairs the window moves. Ignored while bandit_candidate_budget is
+    // set.
+    bool early_rejection = false;
+    std::uint64_t seed = 0;  // of the tie-breaking jitter and shakes; 0 seeds from the clock
+    ThreadPool* thread_pool = nullptr;  // when set, the parents of a layer are expanded in parallel on it
+    // With a pool: deduplicate and keep a bounded top-K per worker inside the expansion tasks instead of merging
+    // every child on one thread afterwards.
+    bool pipelined_layers = false;
+    // Length of the best answer known elsewhere (another solve, another machine); 0 means none. Re-read per layer.
+    const std::atomic<std::size_t>* shared_length_bound = nullptr;
+    const std::atomic<bool>* cancel_flag = nullptr;  // once set, every phase stops as if out of time
+    // Accountant for layers, expansions and the visited set. Over its limit a layer first drops the visited set,
+    // then trims to the beam early, then halves the beam for the rest of the iteration.
+    MemoryBudget* memory_budget = nullptr;
+    // Invoked with every solved answer that is shorter than the previous one reported during a solve.
+    std::function<void(const std::vector<Operation>&)> on_solution;
+};
+
+// Counters of one solve. The per-phase node counts sum to explored_nodes; shortening includes the suffix re-solves.
+struct SearchStats {
+    struct Improvement {
+        double elapsed_ms = 0.0;
+        std::size_t operations = 0;
+        std::size_t unmatched = 0;
+        bool solved = false;
+    };
+
+    std::size_t search_nodes = 0;
+    std::size_t shake_nodes = 0;
+    std::size_t refinement_nodes = 0;
+    std::size_t shortening_nodes = 0;
+    std::size_t duplicate_hits = 0;    // children dropped because the visited set already held their state
+    std::size_t duplicate_misses = 0;  // children whose state entered the visited set
+    std::size_t visited_clears = 0;    // at the node-limit cap or under memory pressure
+    std::size_t iterations = 0;
+    std::size_t shakes_accepted = 0;
+    // Candidates screened out by the window bound (early_rejection), and by their exact metrics. Both count as
+    // explored nodes. Screening comes before the visited-set check, so a screened-out candidate is never a duplicate
+    // hit even if its state was seen before; duplicate_hits drops as screening tightens.
+    std::size_t bound_rejections = 0;
+    std::size_t delta_rejections = 0;
+    std::vector<Improvement> improvements;  // every change of the best answer, in order
+    double overshoot_ms = 0.0;              // elapsed time beyond time_limit_ms
+
+    // Adds the counters of a solve that ran alongside this one; improvements stay those of this solve.
+    void accumulate(const SearchStats& other) noexcept;
 };
 
 struct BeamStackSearchResult {
@@ -43,13 +130,57 @@ struct BeamStackSearchResult {
     bool solved = false;
     std::size_t explored_nodes = 0;
     double elapsed_ms = 0.0;
+    SearchStats stats;
 };
 
-class BeamStackSearchSolver {
+enum class SolvePhase { Search, Refinement, Shortening, Finished };
+
+// Snapshot emitted at every layer boundary, refinement move, shake and phase change of a stepwise solve.
+struct SolveProgress {
+    SolvePhase phase = SolvePhase::Search;
+    double elapsed_ms = 0.0;
+    std::size_t explored_nodes = 0;
+    std::size_t operations = 0;  // length of the best answer so far
+    std::size_t unmatched = 0;   // of the best answer so far
+    bool solved = false;
+};
+
+[[nodiscard]] const char* to_string(SolvePhase phase) noexcept;
+
+// Hand-tuned settings per board size class: n <= 8, n < 16, n < 22, n < 32 and the stress-test boards beyond the
+// contest range, which score children incrementally and cap the candidates per state. Every class screens children
+// early.
+[[nodiscard]] BeamStackSearchConfig make_default_config(std::size_t board_size);
+
+// Solved beats unsolved; then fewer operations when solved, fewer unmatched pairs otherwise.
+[[nodiscard]] bool is_better_result(const BeamStackSearchResult& a, const BeamStackSearchResult& b) noexcept;
+
+// Policies live in solver/search_policies.hpp. Member definitions are in the .cpp, which explicitly instantiates the
+// combinations named below; a new combination is added there.
+struct WeightedEvaluator;
+struct DistanceEvaluator;
+struct ImpactOrderedGenerator;
+struct ExhaustiveGenerator;
+struct PartialSortSelector;
+struct NthElementSelector;
+
+template <typename Evaluator, typename CandidateGenerator, typename Selector>
+class BasicBeamStackSearchSolver {
 public:
-    explicit BeamStackSearchSolver(BeamStackSearchConfig config = {});
+    explicit BasicBeamStackSearchSolver(BeamStackSearchConfig config = {});
 
     [[nodiscard]] BeamStackSearchResult solve(const Problem& problem);
+    // Starts from a previous answer: a solved one bounds the search to strictly shorter answers and seeds the
+    // suffix re-solver, a partial one becomes the search root and the input of the greedy refinement.
+    [[nodiscard]] BeamStackSearchResult solve(const Problem& problem, const std::vector<Operation>& warm_start);
+    // Coroutine form of solve(): every resumption runs to the next layer boundary, refinement move or shake, keeping
+    // the best answer so far in `result`. Time is measured on `timer`, so pausing it between resumptions suspends the
+    // time limit as well. All arguments must outlive the generator.
+    [[nodiscard]] Generator<SolveProgress> solve_steps(const Problem& problem, const std::vector<Operation>& warm_start,
+                                                       Timer& timer, BeamStackSearchResult& result);
+    [[nodiscard]] const BeamStackSearchConfig& config() const noexcept { return config_; }
+    // Rotation size statistics of the latest solve; null unless bandit_candidate_budget is set.
+    [[nodiscard]] const RotationBandit* rotation_bandit() const noexcept { return bandit_.get(); }
 
 private:
     struct Node {
@@ -65,6 +196,51 @@ private:
         std::size_t max_depth{};
         std::size_t max_nodes{};
         std::size_t max_children_per_node{};
+        std::size_t length_bound{};  // when non-zero, only answers shorter than this are pursued
+    };
+
+    struct LayerExpansion {
+        std::vector<std::vector<Node>> children;  // per parent, already trimmed to the per-node child limit
+        std::vector<std::size_t> discarded;       // children scored but dropped by the trim, or screened out
+        std::size_t bound_rejections = 0;
+        std::size_t delta_rejections = 0;
+        std::size_t duplicate_hits = 0;  // children dropped before the trim as already seen
+    };
+
+    struct PipelinedLayer {
+        std::vector<Node> next_layer;
+        bool solved = false;
+        bool reached_limit = false;
+    };
+
+    // State of one tournament chain; `path` holds only the operations after the shaken root.
+    struct ShakeState {
+        Field field;
+        std::vector<Operation> path;
+        PairMetrics metrics;
+        double score = 0.0;
+    };
+
+    struct ShakeChain {
+        ShakeState best;
+        std::size_t explored = 0;
+        bool moved = false;
+    };
+
+    // Per-parent state of early_rejection. A child is rejected below the worse of two scores: the worst of the
+    // parent's kept children once there are `keep` of them, and `floor`, which the caller raises to the worst node
+    // the layer is already certain to keep.
+    struct ChildScreen {
+        bool enabled = false;
+        std::size_t keep = 0;             // 0 when the parent keeps every child
+        std::vector<double> kept;         // min-heap of the best `keep` child scores so far
+        double floor = std::numeric_limits<double>::lowest();
+        std::vector<std::size_t> prefix;  // summed-area table of the parent's unmatched cells
+        const PairIndex* parent_pairs = nullptr;  // the parent's index, when it has one
+        std::optional<PairIndex> own_index;       // built otherwise
+        std::size_t bound_rejections = 0;
+        std::size_t delta_rejections = 0;
+        std::optional<PairMetrics> exact;  // stage-two metrics of the candidate just let through, if computed
     };
 
     struct IterationOutcome {
@@ -72,20 +248,103 @@ private:
         bool reached_limit = false;
         Node best_unsolved;
         bool has_best_unsolved = false;
+        std::size_t beam_width = 0;  // as narrowed by the memory budget by the end of the iteration
     };
 
     [[nodiscard]] double evaluate(const Node& node) const;
+    [[nodiscard]] double evaluate(const Node& node, Random& random) const;
+    // Score of a state with these metrics reached after `depth` moves, `length` of them in its answer.
+    [[nodiscard]] double evaluate(const PairMetrics& metrics, std::size_t depth, std::size_t length,
+                                  Random& random) const;
+    [[nodiscard]] std::uint64_t state_hash(const Field& field) const;
+    // Initial field of `problem`, tracking one-rotation pairs when the evaluator weighs them and rotated hashes when
+    // the visited set is keyed on canonical hashes.
+    [[nodiscard]] Field start_field(const Problem& problem) const;
+    // Metrics of a search root, and of a child of a node with metrics `parent`. With lock_completed_edges a child
+    // scans only the parent's active rectangle, which then shrinks past edges that have become complete.
+    [[nodiscard]] PairMetrics root_metrics(const Field& field) const;
+    [[nodiscard]] PairMetrics child_metrics(const Field& field, const PairMetrics& parent) const;
+    // The same for `field`, the parent's board rotated by `op`, taken from the parent's `index` when it is set.
+    [[nodiscard]] PairMetrics child_metrics(const Field& field, const PairMetrics& parent, const Operation& op,
+                                            const std::optional<PairIndex>& index) const;
+    // The same, reusing the metrics the screen computed for `op` when it has them.
+    [[nodiscard]] PairMetrics child_metrics(const Field& field, const PairMetrics& parent, const Operation& op,
+                                            const std::optional<PairIndex>& index, ChildScreen& screen) const;
+    // Completes metrics taken from a pair index: one-rotation pairs and, with lock_completed_edges, the active area.
+    [[nodiscard]] PairMetrics finish_child_metrics(const Field& field, const PairMetrics& parent,
+                                                   PairMetrics metrics) const;
+    // Pair index of a beam parent, built only when its children are scored incrementally.
+    [[nodiscard]] std::optional<PairIndex> parent_index(const Field& field) const;
     [[nodiscard]] std::vector<Operation> generate_operations(const Field& field, const std::vector<Operation>& history,
                                                              const PairMetrics& metrics) const;
     void update_best(const Node& node, BeamStackSearchResult& best_result, double& best_score) const;
+    // Appends a point to result.stats.improvements unless its length, unmatched count and solved flag match the last.
+    void record_improvement(BeamStackSearchResult& result) const;
+    // Feeds the bandit with how each child of `parent` compares to it.
+    void record_rotation_rewards(const Node& parent, const std::vector<Node>& children) const;
     [[nodiscard]] SearchLimits derive_limits(std::size_t board_size) const;
-    IterationOutcome run_search_iteration(const Node& root, const SearchLimits& limits, Timer& timer,
-                                          BeamStackSearchResult& result, double& best_score) const;
-    bool greedy_refinement(const Problem& problem, BeamStackSearchResult& result, Timer& timer, double& best_score) const;
+    [[nodiscard]] bool out_of_time(const Timer& timer) const noexcept;
+    [[nodiscard]] std::size_t effective_length_bound(const SearchLimits& limits) const noexcept;
+    // Children of `parent` that survive the per-node trim when it has `children` of them.
+    [[nodiscard]] std::size_t child_limit(const Node& parent, const SearchLimits& limits,
+                                          std::size_t children) const noexcept;
+    void keep_best_children(const Node& parent, const SearchLimits& limits, std::vector<Node>& children) const;
+    [[nodiscard]] ChildScreen screen_for(const Node& parent, const SearchLimits& limits, std::size_t candidates,
+                                         const std::optional<PairIndex>& index) const;
+    // True when the child of `parent` by `op` cannot enter the next layer. A child that would beat
+    // `best_unsolved` on unmatched pairs, then distance, is never rejected.
+    [[nodiscard]] bool screen_out(ChildScreen& screen, const Node& parent, const Operation& op,
+                                  const PairMetrics* best_unsolved) const;
+    static void screen_keep(ChildScreen& screen, double score);
+    // Expands the parents layer[begin, end) concurrently on the configured pool. Like the sequential path, each task
+    // drops children already in `visited` (read only while the tasks run) or repeated among its own before the trim,
+    // and screens them against `floor` raised to the beam_width-th best score its worker has kept so far.
+    [[nodiscard]] LayerExpansion expand_layer(const std::vector<Node>& layer, std::size_t begin, std::size_t end,
+                                              const SearchLimits& limits, std::size_t beam_width,
+                                              const std::unordered_set<std::uint64_t>* visited, double floor,
+                                              const PairMetrics* best_unsolved, const Timer& timer) const;
+    [[nodiscard]] SolveProgress progress(SolvePhase phase, const BeamStackSearchResult& result,
+                                         const Timer& timer) const;
+    // Body of solve_steps. It switches the allocation phase with set_allocation_phase, which solve_steps confines to
+    // each resumption.
+    [[nodiscard]] Generator<SolveProgress> run_solve(const Problem& problem, const std::vector<Operation>& warm_start,
+                                                     Timer& timer, BeamStackSearchResult& result);
+    [[nodiscard]] PipelinedLayer pipeline_layer(const std::vector<Node>& layer, const SearchLimits& limits,
+                                                std::size_t beam_width, StripedHashSet* visited, const Timer& timer,
+                                                BeamStackSearchResult& result, double& best_score,
+                                                IterationOutcome& outcome) const;
+    // Yields after every layer; the outcome is complete once the generator finishes.
+    [[nodiscard]] Generator<SolveProgress> run_search_iteration(const Node& root, const SearchLimits& limits,
+                                                                Timer& timer, BeamStackSearchResult& result,
+                                                                double& best_score, IterationOutcome& outcome) const;
+    // Yields after every accepted move.
+    [[nodiscard]] Generator<SolveProgress> greedy_refinement(const Problem& problem, BeamStackSearchResult& result,
+                                                             Timer& timer, double& best_score) const;
     bool apply_shake(Node& node, BeamStackSearchResult& result, Timer& timer, double& best_score) const;
+    [[nodiscard]] ShakeChain run_shake_chain(const Node& root, Random& random, PairIndex::Scratch& scratch,
+                                             const Timer& timer) const;
+    bool shake_tournament(Node& node, BeamStackSearchResult& result, Timer& timer, double& best_score) const;
+    bool prune_operations(const Problem& problem, BeamStackSearchResult& result) const;
+    // Yields after every layer of every suffix re-solve; sets `improved` when the answer got shorter.
+    [[nodiscard]] Generator<SolveProgress> shorten_solution(const Problem& problem, const SearchLimits& base_limits,
+                                                            BeamStackSearchResult& result, Timer& timer,
+                                                            double& best_score, bool& improved) const;
 
     BeamStackSearchConfig config_;
     mutable Random random_;
+    std::shared_ptr<RotationBandit> bandit_;
+    std::shared_ptr<const RotationReach> reach_;
+    const Timer* solve_timer_ = nullptr;  // of the running solve, for the improvement timestamps
 };
 
+using BeamStackSearchSolver =
+    BasicBeamStackSearchSolver<WeightedEvaluator, ImpactOrderedGenerator, PartialSortSelector>;
+// Variants benchmarked against the default by `solver_bench policies`.
+using DistanceBeamSearchSolver =
+    BasicBeamStackSearchSolver<DistanceEvaluator, ImpactOrderedGenerator, PartialSortSelector>;
+using ExhaustiveBeamSearchSolver =
+    BasicBeamStackSearchSolver<WeightedEvaluator, ExhaustiveGenerator, PartialSortSelector>;
+using UnorderedBeamSearchSolver =
+    BasicBeamStackSearchSolver<WeightedEvaluator, ImpactOrderedGenerator, NthElementSelector>;
+
 }  // namespace proc36
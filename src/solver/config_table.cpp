@@ -0,0 +1,222 @@
+#include "solver/config_table.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string_view>
+
+namespace proc36 {
+
+namespace {
+
+constexpr std::string_view kHeader = "proc36-config-table v1";
+
+struct SizeKnob {
+    const char* name;
+    std::size_t BeamStackSearchConfig::*member;
+};
+
+struct RealKnob {
+    const char* name;
+    double BeamStackSearchConfig::*member;
+};
+
+struct FlagKnob {
+    const char* name;
+    bool BeamStackSearchConfig::*member;
+};
+
+constexpr SizeKnob kSizeKnobs[] = {
+    {"beam_width", &BeamStackSearchConfig::beam_width},
+    {"max_depth", &BeamStackSearchConfig::max_depth},
+    {"max_nodes", &BeamStackSearchConfig::max_nodes},
+    {"max_children_per_node", &BeamStackSearchConfig::max_children_per_node},
+    {"beam_width_cap", &BeamStackSearchConfig::beam_width_cap},
+    {"max_iterations", &BeamStackSearchConfig::max_iterations},
+    {"refinement_attempts", &BeamStackSearchConfig::refinement_attempts},
+    {"refinement_sample", &BeamStackSearchConfig::refinement_sample},
+    {"shake_attempts", &BeamStackSearchConfig::shake_attempts},
+    {"shake_max_length", &BeamStackSearchConfig::shake_max_length},
+    {"shake_tournament_size", &BeamStackSearchConfig::shake_tournament_size},
+    {"shake_beam_width", &BeamStackSearchConfig::shake_beam_width},
+    {"shake_beam_depth", &BeamStackSearchConfig::shake_beam_depth},
+    {"lns_segment_nodes", &BeamStackSearchConfig::lns_segment_nodes},
+    {"bandit_candidate_budget", &BeamStackSearchConfig::bandit_candidate_budget},
+    {"candidate_limit", &BeamStackSearchConfig::candidate_limit},
+};
+
+constexpr RealKnob kRealKnobs[] = {
+    {"time_limit_ms", &BeamStackSearchConfig::time_limit_ms},
+    {"match_weight", &BeamStackSearchConfig::match_weight},
+    {"unmatched_penalty", &BeamStackSearchConfig::unmatched_penalty},
+    {"depth_penalty", &BeamStackSearchConfig::depth_penalty},
+    {"operation_penalty", &BeamStackSearchConfig::operation_penalty},
+    {"total_distance_penalty", &BeamStackSearchConfig::total_distance_penalty},
+    {"max_distance_penalty", &BeamStackSearchConfig::max_distance_penalty},
+    {"one_rotation_weight", &BeamStackSearchConfig::one_rotation_weight},
+    {"refinement_time_budget_ms", &BeamStackSearchConfig::refinement_time_budget_ms},
+    {"shake_time_ratio", &BeamStackSearchConfig::shake_time_ratio},
+    {"shake_accept_equal_probability", &BeamStackSearchConfig::shake_accept_equal_probability},
+    {"lns_time_budget_ms", &BeamStackSearchConfig::lns_time_budget_ms},
+};
+
+constexpr FlagKnob kFlagKnobs[] = {
+    {"use_global_hash", &BeamStackSearchConfig::use_global_hash},
+    {"canonical_hashing", &BeamStackSearchConfig::canonical_hashing},
+    {"adaptive_limits", &BeamStackSearchConfig::adaptive_limits},
+    {"pipelined_layers", &BeamStackSearchConfig::pipelined_layers},
+    {"lock_completed_edges", &BeamStackSearchConfig::lock_completed_edges},
+    {"incremental_metrics", &BeamStackSearchConfig::incremental_metrics},
+    {"early_rejection", &BeamStackSearchConfig::early_rejection},
+};
+
+[[noreturn]] void malformed(std::size_t line, const std::string& message) {
+    throw std::runtime_error("Malformed config table (line " + std::to_string(line) + "): " + message);
+}
+
+void apply_setting(BeamStackSearchConfig& config, const std::string& key, std::istringstream& values,
+                   std::size_t line) {
+    if (key == "rotation_sizes") {
+        config.rotation_sizes.clear();
+        std::size_t k = 0;
+        while (values >> k) {
+            config.rotation_sizes.push_back(k);
+        }
+        if (config.rotation_sizes.empty()) {
+            malformed(line, "rotation_sizes needs at least one size");
+        }
+        return;
+    }
+    for (const auto& knob : kSizeKnobs) {
+        if (key == knob.name) {
+            if (!(values >> config.*knob.member)) {
+                malformed(line, key + " expects a non-negative integer");
+            }
+            return;
+        }
+    }
+    for (const auto& knob : kRealKnobs) {
+        if (key == knob.name) {
+            if (!(values >> config.*knob.member)) {
+                malformed(line, key + " expects a number");
+            }
+            return;
+        }
+    }
+    for (const auto& knob : kFlagKnobs) {
+        if (key == knob.name) {
+            int flag = 0;
+            if (!(values >> flag) || (flag != 0 && flag != 1)) {
+                malformed(line, key + " expects 0 or 1");
+            }
+            config.*knob.member = flag != 0;
+            return;
+        }
+    }
+    malformed(line, "unknown key " + key);
+}
+
+}  // namespace
+
+ConfigTable ConfigTable::load_from_file(const std::string& path) {
+    std::ifstream ifs(path);
+    if (!ifs) {
+        throw std::runtime_error("Failed to open config table: " + path);
+    }
+    std::ostringstream oss;
+    oss << ifs.rdbuf();
+    return from_string(oss.str());
+}
+
+ConfigTable ConfigTable::from_string(const std::string& text) {
+    std::istringstream iss(text);
+    std::string line;
+    std::size_t number = 1;
+    if (!std::getline(iss, line) || line != kHeader) {
+        malformed(number, "expected header \"" + std::string(kHeader) + "\"");
+    }
+
+    ConfigTable table;
+    std::size_t size = 0;  // of the open entry, 0 outside one
+    BeamStackSearchConfig config;
+    while (std::getline(iss, line)) {
+        ++number;
+        std::istringstream fields(line);
+        std::string key;
+        if (!(fields >> key) || key.front() == '#') {
+            continue;
+        }
+        if (key == "size") {
+            if (size != 0) {
+                malformed(number, "size inside an open entry");
+            }
+            if (!(fields >> size) || size == 0) {
+                malformed(number, "size expects a positive integer");
+            }
+            config = make_default_config(size);
+        } else if (key == "end") {
+            if (size == 0) {
+                malformed(number, "end without size");
+            }
+            table.set(size, config);
+            size = 0;
+        } else if (size == 0) {
+            malformed(number, key + " outside an entry");
+        } else {
+            apply_setting(config, key, fields, number);
+        }
+    }
+    if (size != 0) {
+        malformed(number, "missing end");
+    }
+    return table;
+}
+
+void ConfigTable::save_to_file(const std::string& path) const {
+    std::ofstream ofs(path, std::ios::trunc);
+    if (!ofs) {
+        throw std::runtime_error("Failed to open config table: " + path);
+    }
+    ofs << to_string();
+    if (!ofs) {
+        throw std::runtime_error("Failed to write config table: " + path);
+    }
+}
+
+std::string ConfigTable::to_string() const {
+    std::ostringstream oss;
+    oss.precision(10);
+    oss << kHeader << '\n';
+    for (const auto& [size, config] : entries_) {
+        oss << "size " << size << '\n';
+        for (const auto& knob : kSizeKnobs) {
+            oss << knob.name << ' ' << config.*knob.member << '\n';
+        }
+        for (const auto& knob : kRealKnobs) {
+            oss << knob.name << ' ' << config.*knob.member << '\n';
+        }
+        for (const auto& knob : kFlagKnobs) {
+            oss << knob.name << ' ' << (config.*knob.member ? 1 : 0) << '\n';
+        }
+        oss << "rotation_sizes";
+        for (const auto k : config.rotation_sizes) {
+            oss << ' ' << k;
+        }
+        oss << "\nend\n";
+    }
+    return oss.str();
+}
+
+void ConfigTable::set(std::size_t max_size, const BeamStackSearchConfig& config) {
+    entries_[max_size] = config;
+}
+
+BeamStackSearchConfig ConfigTable::config_for(std::size_t board_size) const {
+    if (entries_.empty()) {
+        return make_default_config(board_size);
+    }
+    const auto it = entries_.lower_bound(board_size);
+    return it != entries_.end() ? it->second : entries_.rbegin()->second;
+}
+
+}  // namespace proc36
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <string>
+
+#include "solver/beam_stack_search.hpp"
+
+namespace proc36 {
+
+// Per-size solver settings, as written by tune_config and read by `beam_solver --config`. An entry covers boards up
+// to its size; larger boards than any entry use the largest one. Entries start from make_default_config(size), so a
+// hand-written file only needs the knobs it changes. Unknown keys are rejected rather than silently ignored.
+//
+//   proc36-config-table v1
+//   size 12
+//   beam_width 96
+//   rotation_sizes 2 3 4 5
+//   end
+class ConfigTable {
+public:
+    static ConfigTable load_from_file(const std::string& path);
+    static ConfigTable from_string(const std::string& text);
+    void save_to_file(const std::string& path) const;
+    [[nodiscard]] std::string to_string() const;
+
+    void set(std::size_t max_size, const BeamStackSearchConfig& config);
+    [[nodiscard]] bool empty() const noexcept { return entries_.empty(); }
+    // make_default_config(board_size) when the table is empty.
+    [[nodiscard]] BeamStackSearchConfig config_for(std::size_t board_size) const;
+
+private:
+    std::map<std::size_t, BeamStackSearchConfig> entries_;
+};
+
+}  // namespace proc36
@@ -0,0 +1,400 @@
+#include "solver/decomposition.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "lib/field.hpp"
+#include "lib/random.hpp"
+#include "lib/thread_pool.hpp"
+#include "lib/timer.hpp"
+
+namespace proc36 {
+
+namespace {
+
+constexpr double kGatherTimeShare = 0.2;  // of the time limit; past it the whole board is solved instead
+constexpr double kMinTimeLeftMs = 1e-3;   // stands in for a spent time limit, since 0 means unlimited
+constexpr std::size_t kDecomposeMinSize = 20;  // smaller boards are solved whole by default
+// Region sides tried by default_splits, in order. On one core a 6x6 region needs about half a second, more than
+// its share of the time limit on 24x24, while 4x4 ones solve in a fraction of it; side 2 cannot work at all, since
+// a 2x2 rotation keeps diagonal cells diagonal.
+constexpr std::size_t kRegionSides[] = {4, 6};
+
+// Sorts pairs into regions by recursive bisection. Each step cuts a rectangle whose pairs all lie inside it into two
+// halves along a region border (both hold an even number of cells, as regions do), assigns every pair to a half and
+// then exchanges misplaced cells across the border two at a time: each cell is first routed next to the border with
+// rotations confined to its own half, and one 2x2 rotation across the border swaps their sides. Nothing else
+// crosses, so every step keeps the pairs of the other halves in place.
+class Gatherer {
+public:
+    Gatherer(Field field, std::size_t side, double deadline_ms, const Timer& timer,
+             const std::atomic<bool>* cancel_flag)
+        : field_(std::move(field)), side_(side), deadline_ms_(deadline_ms), timer_(timer), cancel_flag_(cancel_flag) {
+        const auto n = field_.size();
+        for (std::size_t y = 0; y < n; ++y) {
+            for (std::size_t x = 0; x < n; ++x) {
+                if (field_.at(x, y) < 0 || static_cast<std::size_t>(field_.at(x, y)) >= n * n / 2) {
+                    throw std::invalid_argument("Decomposition needs pair values 0..n*n/2-1");
+                }
+            }
+        }
+        side_of_.resize(n * n / 2);
+    }
+
+    // False when the time ran out or the board does not hold every value exactly twice.
+    [[nodiscard]] bool gather() { return bisect(Rect{0, 0, field_.size(), field_.size()}); }
+
+    [[nodiscard]] const Field& field() const noexcept { return field_; }
+    [[nodiscard]] std::vector<Operation>& operations() noexcept { return operations_; }
+
+private:
+    [[nodiscard]] bool out_of_time() const noexcept {
+        return timer_.elapsed_ms() >= deadline_ms_ ||
+               (cancel_flag_ != nullptr && cancel_flag_->load(std::memory_order_relaxed));
+    }
+
+    void rotate(std::size_t x, std::size_t y, std::size_t size) {
+        field_.apply(Operation{x, y, size});
+        operations_.push_back(Operation{x, y, size});
+    }
+
+    [[nodiscard]] static Position rotated(std::size_t x, std::size_t y, std::size_t size, const Position& cell) {
+        return Position{x + size - 1 - (cell.y - y), y + (cell.x - x)};
+    }
+
+    // Moves the cell at `from` to `to` with the fewest rotations inside `area`, by a breadth-first search over the
+    // positions of that one cell. Rotations reach every position of a rectangle at least 2 wide and high.
+    void route(const Position& from, const Position& to, const Rect& area) {
+        if (from == to) {
+            return;
+        }
+        const auto index = [&](const Position& cell) { return (cell.y - area.y) * area.width + cell.x - area.x; };
+        const auto largest = std::min(area.width, area.height);
+        std::vector<Operation> reached_by(area.width * area.height, Operation{0, 0, 0});
+        std::vector<Position> parent(area.width * area.height);
+        std::vector<Position> queue{from};
+        reached_by[index(from)].size = 1;  // marks the start
+        for (std::size_t head = 0; head < queue.size() && reached_by[index(to)].size == 0; ++head) {
+            const auto cell = queue[head];
+            for (std::size_t k = 2; k <= largest; ++k) {
+                const auto top = std::max(area.y, cell.y + 1 >= k ? cell.y + 1 - k : 0);
+                const auto left = std::max(area.x, cell.x + 1 >= k ? cell.x + 1 - k : 0);
+                for (std::size_t y = top; y <= cell.y && y + k <= area.y + area.height; ++y) {
+                    for (std::size_t x = left; x <= cell.x && x + k <= area.x + area.width; ++x) {
+                        const auto next = rotated(x, y, k, cell);
+                        if (reached_by[index(next)].size == 0) {
+                            reached_by[index(next)] = Operation{x, y, k};
+                            parent[index(next)] = cell;
+                            queue.push_back(next);
+                        }
+                    }
+                }
+            }
+        }
+        if (reached_by[index(to)].size == 0) {
+            throw std::logic_error("Decomposition could not route a cell");
+        }
+        std::vector<Operation> path;
+        for (auto cell = to; !(cell == from); cell = parent[index(cell)]) {
+            path.push_back(reached_by[index(cell)]);
+        }
+        for (auto it = path.rbegin(); it != path.rend(); ++it) {
+            rotate(it->x, it->y, it->size);
+        }
+    }
+
+    // Closest cell to the border among those of `half` whose pair belongs on the other side.
+    [[nodiscard]] std::optional<Position> misplaced(const Rect& half, bool first_half, bool horizontal,
+                                                    std::size_t border) const {
+        std::optional<Position> best;
+        std::size_t best_distance = 0;
+        for (std::size_t y = half.y; y < half.y + half.height; ++y) {
+            for (std::size_t x = half.x; x < half.x + half.width; ++x) {
+                if (side_of_[static_cast<std::size_t>(field_.at(x, y))] == first_half) {
+                    continue;
+                }
+                const auto along = horizontal ? y : x;
+                const auto distance = along < border ? border - along : along - border;
+                if (!best || distance < best_distance) {
+                    best = Position{x, y};
+                    best_distance = distance;
+                }
+            }
+        }
+        return best;
+    }
+
+    [[nodiscard]] bool bisect(const Rect& area) {
+        if (area.width <= side_ && area.height <= side_) {
+            return true;
+        }
+        // Cuts the longer side on a region border, as close to its middle as the regions allow.
+        const bool horizontal = area.height >= area.width;
+        const auto length = horizontal ? area.height : area.width;
+        const auto cut = length / side_ / 2 * side_;
+        const auto border = (horizontal ? area.y : area.x) + cut;
+        const Rect first = horizontal ? Rect{area.x, area.y, area.width, cut} : Rect{area.x, area.y, cut, area.height};
+        const Rect second = horizontal ? Rect{area.x, border, area.width, length - cut}
+                                       : Rect{border, area.y, length - cut, area.height};
+        if (!assign_halves(area, first, horizontal, border)) {
+            return false;
+        }
+
+        // Clockwise, a 2x2 window straddling the border sends its top-right cell down and its bottom-left one up
+        // (horizontal border), or its top-left cell right and its bottom-right one left (vertical border).
+        while (true) {
+            if (out_of_time()) {
+                return false;
+            }
+            const auto up = misplaced(first, true, horizontal, border);
+            const auto down = misplaced(second, false, horizontal, border);
+            if (!up || !down) {
+                break;  // the halves hold the same number of cells, so both run out together
+            }
+            if (horizontal) {
+                const auto x = std::clamp(down->x, area.x, area.x + area.width - 2);
+                route(*up, Position{x + 1, border - 1}, first);
+                route(*down, Position{x, border}, second);
+                rotate(x, border - 1, 2);
+            } else {
+                const auto y = std::clamp(up->y, area.y, area.y + area.height - 2);
+                route(*up, Position{border - 1, y}, first);
+                route(*down, Position{border, y + 1}, second);
+                rotate(border - 1, y, 2);
+            }
+        }
+        return bisect(first) && bisect(second);
+    }
+
+    // Pairs inside one half stay there. Of the pairs split by the border, the half whose cell is cheapest to bring
+    // across goes to the other side, so each half ends up with exactly as many pairs as it has room for.
+    [[nodiscard]] bool assign_halves(const Rect& area, const Rect& first, bool horizontal, std::size_t border) {
+        const auto n = field_.size();
+        std::vector<Position> seen(n * n / 2, Position{n, n});
+        struct Split {
+            std::size_t value;
+            long preference;  // cost of bringing the second-half cell over minus that of the first-half cell
+        };
+        std::vector<Split> splits;
+        const auto distance = [&](const Position& cell) {
+            const auto along = horizontal ? cell.y : cell.x;
+            return static_cast<long>(along < border ? border - along : along - border);
+        };
+        for (std::size_t y = area.y; y < area.y + area.height; ++y) {
+            for (std::size_t x = area.x; x < area.x + area.width; ++x) {
+                const auto value = static_cast<std::size_t>(field_.at(x, y));
+                const Position cell{x, y};
+                if (seen[value].x == n) {
+                    seen[value] = cell;
+                    continue;
+                }
+                const bool a = first.contains(seen[value]);
+                const bool b = first.contains(cell);
+                if (a == b) {
+                    side_of_[value] = a;
+                } else {
+                    const auto& in_second = a ? cell : seen[value];
+                    const auto& in_first = a ? seen[value] : cell;
+                    splits.push_back({value, distance(in_second) - distance(in_first)});
+                }
+                seen[value] = Position{n + 1, n};  // complete
+            }
+        }
+        for (std::size_t y = area.y; y < area.y + area.height; ++y) {
+            for (std::size_t x = area.x; x < area.x + area.width; ++x) {
+                if (seen[static_cast<std::size_t>(field_.at(x, y))].x == n) {
+                    return false;  // a value without its partner in this rectangle
+                }
+            }
+        }
+        std::sort(splits.begin(), splits.end(),
+                  [](const Split& lhs, const Split& rhs) { return lhs.preference < rhs.preference; });
+        for (std::size_t i = 0; i < splits.size(); ++i) {
+            side_of_[splits[i].value] = i < splits.size() / 2;
+        }
+        return true;
+    }
+
+    Field field_;
+    std::size_t side_;
+    double deadline_ms_;
+    const Timer& timer_;
+    const std::atomic<bool>* cancel_flag_;
+    std::vector<Operation> operations_;
+    std::vector<bool> side_of_;  // per value: whether the pair belongs in the first half of the current bisection
+};
+
+Problem region_problem(const Field& field, std::size_t left, std::size_t top, std::size_t side) {
+    Problem region{side, std::vector<int>(side * side)};
+    std::vector<int> renamed(field.size() * field.size() / 2, -1);
+    int next = 0;
+    for (std::size_t y = 0; y < side; ++y) {
+        for (std::size_t x = 0; x < side; ++x) {
+            auto& name = renamed[static_cast<std::size_t>(field.at(left + x, top + y))];
+            if (name < 0) {
+                name = next++;
+            }
+            region.entities[y * side + x] = name;
+        }
+    }
+    return region;
+}
+
+}  // namespace
+
+bool can_decompose(std::size_t board_size, std::size_t splits) noexcept {
+    return splits >= 2 && board_size % splits == 0 && (board_size / splits) % 2 == 0;
+}
+
+std::size_t default_splits(std::size_t board_size) noexcept {
+    if (board_size < kDecomposeMinSize) {
+        return 0;
+    }
+    for (const auto side : kRegionSides) {
+        if (can_decompose(board_size, board_size / side)) {
+            return board_size / side;
+        }
+    }
+    return 0;
+}
+
+BeamStackSearchResult solve_default(BeamStackSearchSolver& solver, const Problem& problem,
+                                    const std::vector<Operation>& warm_start) {
+    if (const auto splits = default_splits(problem.size); splits > 0 && warm_start.empty()) {
+        return solve_decomposed(problem, solver.config(), splits);
+    }
+    return solver.solve(problem, warm_start);
+}
+
+BeamStackSearchResult solve_default(const Problem& problem, const BeamStackSearchConfig& config,
+                                    const std::vector<Operation>& warm_start) {
+    BeamStackSearchSolver solver(config);
+    return solve_default(solver, problem, warm_start);
+}
+
+Generator<SolveProgress> solve_default_steps(BeamStackSearchSolver& solver, const Problem& problem,
+                                             std::vector<Operation> warm_start, Timer& timer,
+                                             BeamStackSearchResult& result) {
+    if (const auto splits = default_splits(problem.size); splits > 0 && warm_start.empty()) {
+        result = solve_decomposed(problem, solver.config(), splits);
+        SolveProgress finished;
+        finished.phase = SolvePhase::Finished;
+        finished.elapsed_ms = timer.elapsed_ms();
+        finished.explored_nodes = result.explored_nodes;
+        finished.operations = result.operations.size();
+        finished.unmatched = result.status.unmatched;
+        finished.solved = result.solved;
+        co_yield finished;
+        co_return;
+    }
+    auto steps = solver.solve_steps(problem, warm_start, timer, result);
+    while (steps.next()) {
+        co_yield steps.value();
+    }
+}
+
+BeamStackSearchResult solve_decomposed(const Problem& problem, const BeamStackSearchConfig& config,
+                                       std::size_t splits) {
+    Timer timer;
+    // Time left of the limit shared out `rounds` ways. 0 stays unlimited, and a spent limit leaves a sliver rather
+    // than 0, which would lift it.
+    const auto time_left = [&](double rounds) {
+        if (config.time_limit_ms <= 0.0) {
+            return 0.0;
+        }
+        return std::max(kMinTimeLeftMs, (config.time_limit_ms - timer.elapsed_ms()) / rounds);
+    };
+    const auto whole_board = [&]() {
+        auto remaining = config;
+        remaining.time_limit_ms = time_left(1.0);
+        BeamStackSearchSolver solver(remaining);
+        auto result = solver.solve(problem);
+        result.elapsed_ms = timer.elapsed_ms();
+        return result;
+    };
+    if (!can_decompose(problem.size, splits)) {
+        return whole_board();
+    }
+
+    const double gather_deadline_ms = config.time_limit_ms > 0.0 ? config.time_limit_ms * kGatherTimeShare
+                                                                   : std::numeric_limits<double>::infinity();
+    std::optional<Gatherer> gatherer;
+    try {
+        gatherer.emplace(problem.make_field(), problem.size / splits, gather_deadline_ms, timer, config.cancel_flag);
+    } catch (const std::invalid_argument&) {
+        return whole_board();  // values outside 0..n*n/2-1 cannot be assigned to regions
+    }
+    if (!gatherer->gather()) {
+        return whole_board();
+    }
+    auto field = gatherer->field();
+
+    // Regions run as tasks on the configured pool (their layer expansions share it), or on a private pool with a
+    // worker per region up to the core count. With fewer workers than regions, each region takes its share of the
+    // time left when it starts, so the time of regions that finish early passes on to the later ones.
+    const auto side = problem.size / splits;
+    const auto count = splits * splits;
+    std::optional<ThreadPool> own_pool;
+    if (config.thread_pool == nullptr) {
+        own_pool.emplace(std::min<std::size_t>(count, std::max(1U, std::thread::hardware_concurrency())));
+    }
+    ThreadPool& pool = config.thread_pool != nullptr ? *config.thread_pool : *own_pool;
+
+    auto region_config = config;
+    std::erase_if(region_config.rotation_sizes, [side](std::size_t k) { return k > side; });
+    region_config.lns_time_budget_ms = 0.0;
+    region_config.shared_length_bound = nullptr;  // bounds answers to the whole board, not to one region
+    region_config.on_solution = nullptr;
+
+    std::vector<BeamStackSearchResult> results(count);
+    std::atomic<std::size_t> started{0};
+    TaskGroup group(pool);
+    for (std::size_t i = 0; i < count; ++i) {
+        group.run([&, i]() {
+            const auto waiting = count - started.fetch_add(1, std::memory_order_relaxed);
+            const auto rounds = (waiting + pool.size() - 1) / pool.size();
+            auto local_config = region_config;
+            local_config.time_limit_ms = time_left(static_cast<double>(rounds));
+            if (config.seed != 0) {
+                local_config.seed = splitmix64(config.seed + i + 1);
+            }
+            BeamStackSearchSolver solver(local_config);
+            results[i] = solver.solve(region_problem(field, i % splits * side, i / splits * side, side));
+        });
+    }
+    group.wait();
+
+    BeamStackSearchResult result;
+    result.operations = std::move(gatherer->operations());
+    for (std::size_t i = 0; i < count; ++i) {
+        const auto left = i % splits * side;
+        const auto top = i / splits * side;
+        for (const auto& op : results[i].operations) {
+            const Operation shifted{op.x + left, op.y + top, op.size};
+            field.apply(shifted);
+            result.operations.push_back(shifted);
+        }
+        result.explored_nodes += results[i].explored_nodes;
+        result.stats.accumulate(results[i].stats);
+    }
+    result.status = field.evaluate_pairs();
+    result.solved = field.is_goal_state();
+    result.elapsed_ms = timer.elapsed_ms();
+    result.stats.improvements.push_back({result.elapsed_ms, result.operations.size(), result.status.unmatched,
+                                         result.solved});
+    if (config.time_limit_ms > 0.0) {
+        result.stats.overshoot_ms = std::max(0.0, result.elapsed_ms - config.time_limit_ms);
+    }
+    if (result.solved && config.on_solution) {
+        config.on_solution(result.operations);
+    }
+    return result;
+}
+
+}  // namespace proc36
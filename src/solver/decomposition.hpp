@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "lib/generator.hpp"
+#include "lib/problem.hpp"
+#include "lib/timer.hpp"
+#include "solver/beam_stack_search.hpp"
+
+namespace proc36 {
+
+// Splits the board into `splits` x `splits` square regions. Recursive bisection first gathers both cells of every
+// pair into one region, exchanging misplaced cells across each border with 2x2 rotations after routing them there
+// with larger ones. The regions are then solved concurrently as independent boards with rotations confined to them,
+// and the answers are concatenated behind the gathering moves. n / splits must be even; other sizes solve the whole
+// board instead, and so do boards whose values are not 0..n*n/2-1 and a gathering that does not finish within a
+// fifth of the time limit (without a limit it always runs to the end).
+[[nodiscard]] BeamStackSearchResult solve_decomposed(const Problem& problem, const BeamStackSearchConfig& config,
+                                                     std::size_t splits = 2);
+
+// Whether solve_decomposed can split a board of `board_size` into `splits` x `splits` regions.
+[[nodiscard]] bool can_decompose(std::size_t board_size, std::size_t splits = 2) noexcept;
+
+// Splits used by beam_solver unless told otherwise: regions of side 4, else 6, on boards from 20 up, where they
+// beat the whole-board search on `solver_bench decompose`; 0 (solve whole) for smaller boards and sizes neither
+// side divides.
+[[nodiscard]] std::size_t default_splits(std::size_t board_size) noexcept;
+
+// The solve every tool runs unless told otherwise: solve_decomposed with default_splits when the board has them and
+// there is no warm start, else `solver` on the whole board. The overload without a solver makes one from `config`.
+[[nodiscard]] BeamStackSearchResult solve_default(BeamStackSearchSolver& solver, const Problem& problem,
+                                                  const std::vector<Operation>& warm_start = {});
+[[nodiscard]] BeamStackSearchResult solve_default(const Problem& problem, const BeamStackSearchConfig& config,
+                                                  const std::vector<Operation>& warm_start = {});
+// Stepwise solve_default: the yields of solver.solve_steps on the whole board, or a single Finished one after a
+// decomposed solve. `solver`, `problem`, `timer` and `result` must outlive the generator.
+[[nodiscard]] Generator<SolveProgress> solve_default_steps(BeamStackSearchSolver& solver, const Problem& problem,
+                                                           std::vector<Operation> warm_start, Timer& timer,
+                                                           BeamStackSearchResult& result);
+
+}  // namespace proc36
@@ -0,0 +1,75 @@
+#include "solver/orientation_portfolio.hpp"
+
+#include <algorithm>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include "lib/symmetry.hpp"
+#include "lib/thread_pool.hpp"
+#include "lib/timer.hpp"
+
+namespace proc36 {
+
+BeamStackSearchResult solve_orientations(const Problem& problem, const BeamStackSearchConfig& config,
+                                         std::size_t orientations, const std::vector<Operation>& warm_start) {
+    const auto count = std::clamp<std::size_t>(orientations, 1, kAllSymmetries.size());
+    Timer timer;
+
+    // Orientations run as tasks on the configured pool (their layer expansions share it), or on a private pool with
+    // one worker per orientation.
+    std::optional<ThreadPool> own_pool;
+    if (config.thread_pool == nullptr) {
+        own_pool.emplace(count);
+    }
+    ThreadPool& pool = config.thread_pool != nullptr ? *config.thread_pool : *own_pool;
+
+    std::vector<BeamStackSearchResult> results(count);
+    std::mutex report_mutex;
+    std::size_t reported_length = 0;  // 0 until the first solution is forwarded
+    TaskGroup group(pool);
+    for (std::size_t i = 0; i < count; ++i) {
+        group.run([&, i]() {
+            const auto symmetry = kAllSymmetries[i];
+            auto local_config = config;
+            if (config.on_solution) {
+                local_config.on_solution = [&, symmetry](const std::vector<Operation>& ops) {
+                    const auto mapped = transform_operations(ops, problem.size, inverse(symmetry));
+                    std::lock_guard<std::mutex> lock(report_mutex);
+                    if (reported_length == 0 || mapped.size() < reported_length) {
+                        reported_length = mapped.size();
+                        config.on_solution(mapped);
+                    }
+                };
+            }
+            BeamStackSearchSolver solver(local_config);
+            auto result = solver.solve(transform_problem(problem, symmetry),
+                                       transform_operations(warm_start, problem.size, symmetry));
+            result.operations = transform_operations(result.operations, problem.size, inverse(symmetry));
+            results[i] = std::move(result);
+        });
+    }
+    group.wait();
+
+    std::size_t best_index = 0;
+    for (std::size_t i = 1; i < count; ++i) {
+        if (is_better_result(results[i], results[best_index])) {
+            best_index = i;
+        }
+    }
+    BeamStackSearchResult best = results[best_index];
+    for (std::size_t i = 0; i < count; ++i) {
+        if (i != best_index) {
+            best.explored_nodes += results[i].explored_nodes;
+            best.stats.accumulate(results[i].stats);
+        }
+    }
+    best.elapsed_ms = timer.elapsed_ms();
+    // The orientations overshoot independently; what counts is how late the portfolio as a whole returned.
+    if (config.time_limit_ms > 0.0) {
+        best.stats.overshoot_ms = std::max(0.0, best.elapsed_ms - config.time_limit_ms);
+    }
+    return best;
+}
+
+}  // namespace proc36
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "lib/problem.hpp"
+#include "solver/beam_stack_search.hpp"
+
+namespace proc36 {
+
+// Solves up to `orientations` symmetric copies of the problem concurrently (rotations first, then reflections)
+// and returns the best answer mapped back onto the original board. A warm start is mapped into every orientation.
+[[nodiscard]] BeamStackSearchResult solve_orientations(const Problem& problem, const BeamStackSearchConfig& config,
+                                                       std::size_t orientations,
+                                                       const std::vector<Operation>& warm_start = {});
+
+}  // namespace proc36
@@ -0,0 +1,68 @@
+#include "solver/rotation_bandit.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace proc36 {
+
+namespace {
+
+constexpr double kExploration = 1.0;    // weight of the UCB1 confidence term
+constexpr double kUntriedBound = 2.0;   // above any reachable bound, so every size is tried early
+constexpr std::size_t kFloorShare = 4;  // every arm keeps at least budget / (arms * kFloorShare)
+
+}  // namespace
+
+RotationBandit::RotationBandit(std::vector<std::size_t> sizes)
+    : sizes_(std::move(sizes)), arms_(std::make_unique<Arm[]>(sizes_.size())) {}
+
+std::size_t RotationBandit::arm_of(std::size_t size) const noexcept {
+    return static_cast<std::size_t>(std::find(sizes_.begin(), sizes_.end(), size) - sizes_.begin());
+}
+
+void RotationBandit::record(std::size_t arm, std::size_t pulls, std::size_t reward_halves) noexcept {
+    if (arm >= sizes_.size() || pulls == 0) {
+        return;
+    }
+    arms_[arm].pulls.fetch_add(pulls, std::memory_order_relaxed);
+    arms_[arm].reward_halves.fetch_add(reward_halves, std::memory_order_relaxed);
+}
+
+std::size_t RotationBandit::pulls(std::size_t arm) const noexcept {
+    return arms_[arm].pulls.load(std::memory_order_relaxed);
+}
+
+double RotationBandit::mean_reward(std::size_t arm) const noexcept {
+    const auto n = pulls(arm);
+    return n > 0 ? 0.5 * static_cast<double>(arms_[arm].reward_halves.load(std::memory_order_relaxed)) /
+                       static_cast<double>(n)
+                 : 0.0;
+}
+
+std::vector<std::size_t> RotationBandit::quotas(std::size_t budget) const {
+    const auto count = sizes_.size();
+    std::size_t total = 0;
+    for (std::size_t arm = 0; arm < count; ++arm) {
+        total += pulls(arm);
+    }
+    const double log_total = std::log(static_cast<double>(std::max<std::size_t>(total, 1)));
+
+    std::vector<double> bounds(count);
+    double bound_sum = 0.0;
+    for (std::size_t arm = 0; arm < count; ++arm) {
+        const auto n = pulls(arm);
+        bounds[arm] = n == 0 ? kUntriedBound
+                             : mean_reward(arm) + kExploration * std::sqrt(2.0 * log_total / static_cast<double>(n));
+        bound_sum += bounds[arm];
+    }
+
+    const auto floor = std::max<std::size_t>(1, budget / std::max<std::size_t>(1, count * kFloorShare));
+    std::vector<std::size_t> out(count);
+    for (std::size_t arm = 0; arm < count; ++arm) {
+        const auto share = static_cast<std::size_t>(std::ceil(static_cast<double>(budget) * bounds[arm] / bound_sum));
+        out[arm] = std::max(floor, share);
+    }
+    return out;
+}
+
+}  // namespace proc36
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace proc36 {
+
+// UCB1 over the rotation sizes of one solve. An evaluated child earns 1 when it has fewer unmatched pairs than its
+// parent, 1/2 when it only shortens the total pair distance and 0 otherwise. quotas() splits a per-state candidate
+// budget across the sizes in proportion to their upper confidence bounds, with a floor so no size starves.
+// record() may be called from any thread.
+class RotationBandit {
+public:
+    explicit RotationBandit(std::vector<std::size_t> sizes);
+
+    [[nodiscard]] const std::vector<std::size_t>& sizes() const noexcept { return sizes_; }
+    // Index of `size` in sizes(), or sizes().size() when it is not an arm.
+    [[nodiscard]] std::size_t arm_of(std::size_t size) const noexcept;
+
+    // `reward_halves` is the summed reward of `pulls` children, in units of 1/2.
+    void record(std::size_t arm, std::size_t pulls, std::size_t reward_halves) noexcept;
+
+    // Per-arm caps, in the order of sizes(), summing to at least `budget`.
+    [[nodiscard]] std::vector<std::size_t> quotas(std::size_t budget) const;
+
+    [[nodiscard]] std::size_t pulls(std::size_t arm) const noexcept;
+    [[nodiscard]] double mean_reward(std::size_t arm) const noexcept;
+
+private:
+    struct Arm {
+        std::atomic<std::size_t> pulls{0};
+        std::atomic<std::size_t> reward_halves{0};
+    };
+
+    std::vector<std::size_t> sizes_;
+    std::unique_ptr<Arm[]> arms_;
+};
+
+}  // namespace proc36
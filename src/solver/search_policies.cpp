@@ -0,0 +1,189 @@
+#include "solver/search_policies.hpp"
+
+#include <cstdint>
+#include <limits>
+
+namespace proc36 {
+
+std::vector<Operation> ImpactOrderedGenerator::generate(const BeamStackSearchConfig& config, const Field& field,
+                                                        const std::vector<Operation>& history,
+                                                        const PairMetrics& metrics) {
+    const auto board_size = field.size();
+    std::vector<Operation> operations;
+    operations.reserve(board_size * board_size);
+
+    struct Candidate {
+        Operation op;
+        std::size_t impact;
+    };
+    std::vector<Candidate> candidates;
+
+    const auto area = metrics.active.empty() ? Rect{0, 0, board_size, board_size} : metrics.active;
+    const Operation* last_op = history.empty() ? nullptr : &history.back();
+    const bool use_mask = metrics.status.unmatched > 0;
+    // Nodes scored incrementally carry no mask; it is rebuilt here, once per expanded state.
+    PairMetrics scanned;
+    const auto* mask = &metrics.unmatched_mask;
+    if (use_mask && mask->size() != field.cell_count()) {
+        scanned = field.evaluate_pair_metrics(area);
+        mask = &scanned.unmatched_mask;
+    }
+    std::vector<std::size_t> prefix;
+    std::vector<Position> unmatched_cells;
+    bool sparse = false;
+
+    auto area_sum = [&](std::size_t x0, std::size_t y0, std::size_t k) -> std::size_t {
+        if (!use_mask) {
+            return 1;  // treat as impactful to avoid pruning everything
+        }
+        const std::size_t stride = board_size + 1;
+        const std::size_t x1 = x0 + k;
+        const std::size_t y1 = y0 + k;
+        return prefix[y1 * stride + x1] - prefix[y0 * stride + x1] - prefix[y1 * stride + x0] + prefix[y0 * stride + x0];
+    };
+
+    if (use_mask) {
+        // Few unmatched cells on a large board: counting the windows around each of them is cheaper than sliding
+        // every window of every size over a prefix sum.
+        std::size_t windows = 0;
+        std::size_t hits = 0;
+        for (auto size : config.rotation_sizes) {
+            if (size >= 2 && size <= std::min(area.width, area.height)) {
+                windows += (area.width - size + 1) * (area.height - size + 1);
+                hits += size * size;
+            }
+        }
+        sparse = 2 * metrics.status.unmatched * hits < windows;
+        if (sparse) {
+            for (std::size_t y = area.y; y < area.y + area.height; ++y) {
+                for (std::size_t x = area.x; x < area.x + area.width; ++x) {
+                    if ((*mask)[y * board_size + x] != 0) {
+                        unmatched_cells.push_back(Position{x, y});
+                    }
+                }
+            }
+        } else {
+            prefix.assign((board_size + 1) * (board_size + 1), 0);
+            const std::size_t stride = board_size + 1;
+            for (std::size_t y = 0; y < board_size; ++y) {
+                for (std::size_t x = 0; x < board_size; ++x) {
+                    const auto value = static_cast<std::size_t>((*mask)[y * board_size + x]);
+                    prefix[(y + 1) * stride + (x + 1)] = value + prefix[y * stride + (x + 1)] +
+                                                         prefix[(y + 1) * stride + x] - prefix[y * stride + x];
+                }
+            }
+        }
+        candidates.reserve(board_size * board_size);
+    }
+
+    const auto sizes_in_area = static_cast<std::size_t>(
+        std::count_if(config.rotation_sizes.begin(), config.rotation_sizes.end(),
+                      [&](std::size_t size) { return size >= 2 && size <= std::min(area.width, area.height); }));
+    const auto quota = config.candidate_limit > 0 && sizes_in_area > 0
+                           ? std::max<std::size_t>(1, config.candidate_limit / sizes_in_area)
+                           : std::numeric_limits<std::size_t>::max();
+    std::vector<std::uint32_t> corners;  // packed y, x of the windows of one size around each unmatched cell
+
+    for (auto size : config.rotation_sizes) {
+        if (size < 2 || size > std::min(area.width, area.height)) {
+            continue;
+        }
+        const auto size_begin = candidates.size();
+        const auto skip = [&](const Operation& op) {
+            // avoid immediately re-applying the same rotation
+            return last_op != nullptr && last_op->x == op.x && last_op->y == op.y && last_op->size == op.size;
+        };
+        if (sparse) {
+            corners.clear();
+            for (const auto& cell : unmatched_cells) {
+                const auto y_begin = std::max(area.y, cell.y + 1 >= size ? cell.y + 1 - size : 0);
+                const auto y_end = std::min(cell.y, area.y + area.height - size);
+                const auto x_begin = std::max(area.x, cell.x + 1 >= size ? cell.x + 1 - size : 0);
+                const auto x_end = std::min(cell.x, area.x + area.width - size);
+                for (auto y = y_begin; y <= y_end; ++y) {
+                    for (auto x = x_begin; x <= x_end; ++x) {
+                        corners.push_back(static_cast<std::uint32_t>(y << 16 | x));
+                    }
+                }
+            }
+            // Row-major like the sliding scan; a window appears once per unmatched cell it covers.
+            std::sort(corners.begin(), corners.end());
+            for (std::size_t i = 0; i < corners.size();) {
+                auto j = i + 1;
+                while (j < corners.size() && corners[j] == corners[i]) {
+                    ++j;
+                }
+                const Operation op{corners[i] & 0xFFFFU, corners[i] >> 16, size};
+                if (!skip(op)) {
+                    candidates.push_back(Candidate{op, j - i});
+                }
+                i = j;
+            }
+        } else {
+            for (std::size_t y = area.y; y + size <= area.y + area.height; ++y) {
+                for (std::size_t x = area.x; x + size <= area.x + area.width; ++x) {
+                    Operation op{x, y, size};
+                    if (!field.is_valid_operation(op) || skip(op)) {
+                        continue;
+                    }
+                    const auto impact = area_sum(x, y, size);
+                    if (use_mask && impact == 0) {
+                        continue;  // skip operations that don't touch any unmatched cells
+                    }
+                    if (use_mask) {
+                        candidates.push_back(Candidate{op, impact});
+                    } else {
+                        operations.push_back(op);
+                    }
+                }
+            }
+        }
+        if (candidates.size() - size_begin > quota) {
+            const auto first = candidates.begin() + static_cast<std::ptrdiff_t>(size_begin);
+            std::stable_sort(first, candidates.end(),
+                             [](const Candidate& a, const Candidate& b) { return a.impact > b.impact; });
+            candidates.resize(size_begin + quota);
+        }
+    }
+
+    if (use_mask) {
+        std::stable_sort(candidates.begin(), candidates.end(),
+                         [](const Candidate& a, const Candidate& b) { return a.impact > b.impact; });
+        operations.reserve(candidates.size());
+        for (const auto& candidate : candidates) {
+            operations.push_back(candidate.op);
+        }
+    }
+
+    return operations;
+}
+
+std::vector<Operation> ExhaustiveGenerator::generate(const BeamStackSearchConfig& config, const Field& field,
+                                                     const std::vector<Operation>& history,
+                                                     const PairMetrics& metrics) {
+    const auto board_size = field.size();
+    const auto area = metrics.active.empty() ? Rect{0, 0, board_size, board_size} : metrics.active;
+    const Operation* last_op = history.empty() ? nullptr : &history.back();
+    std::vector<Operation> operations;
+    operations.reserve(board_size * board_size);
+    for (auto size : config.rotation_sizes) {
+        if (size < 2 || size > std::min(area.width, area.height)) {
+            continue;
+        }
+        for (std::size_t y = area.y; y + size <= area.y + area.height; ++y) {
+            for (std::size_t x = area.x; x + size <= area.x + area.width; ++x) {
+                const Operation op{x, y, size};
+                if (!field.is_valid_operation(op)) {
+                    continue;
+                }
+                if (last_op != nullptr && last_op->x == op.x && last_op->y == op.y && last_op->size == op.size) {
+                    continue;
+                }
+                operations.push_back(op);
+            }
+        }
+    }
+    return operations;
+}
+
+}  // namespace proc36
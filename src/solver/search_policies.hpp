@@ -0,0 +1,85 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "lib/field.hpp"
+#include "lib/operation.hpp"
+#include "solver/beam_stack_search.hpp"
+
+namespace proc36 {
+
+// Compile-time policies for BasicBeamStackSearchSolver. Each policy is a stateless struct of static functions that
+// read their weights from the config, so the calls from the search loop inline.
+//
+// Evaluator:           static double score(const BeamStackSearchConfig&, const PairMetrics&, std::size_t depth,
+//                                          std::size_t length) noexcept;   higher is better
+// CandidateGenerator:  static std::vector<Operation> generate(const BeamStackSearchConfig&, const Field&,
+//                                                             const std::vector<Operation>& history,
+//                                                             const PairMetrics&);   most promising first,
+//                                                             windows inside metrics.active only
+// Selector:            template <typename Node> static void keep_best(std::vector<Node>&, std::size_t count);
+//                      shrinks to the `count` highest-scoring nodes (count < size)
+
+// Linear mix of every weight in the config.
+struct WeightedEvaluator {
+    [[nodiscard]] static double score(const BeamStackSearchConfig& config, const PairMetrics& metrics,
+                                      std::size_t depth, std::size_t length) noexcept {
+        const auto& status = metrics.status;
+        return config.match_weight * static_cast<double>(status.matched) -
+               config.unmatched_penalty * static_cast<double>(status.unmatched) -
+               config.total_distance_penalty * static_cast<double>(metrics.total_unmatched_distance) -
+               config.max_distance_penalty * static_cast<double>(metrics.max_unmatched_distance) +
+               config.one_rotation_weight * static_cast<double>(metrics.one_rotation_pairs) -
+               config.depth_penalty * static_cast<double>(depth) -
+               config.operation_penalty * static_cast<double>(length);
+    }
+};
+
+// Pair terms only: neither the answer length nor the worst pair distance count.
+struct DistanceEvaluator {
+    [[nodiscard]] static double score(const BeamStackSearchConfig& config, const PairMetrics& metrics, std::size_t,
+                                      std::size_t) noexcept {
+        const auto& status = metrics.status;
+        return config.match_weight * static_cast<double>(status.matched) -
+               config.unmatched_penalty * static_cast<double>(status.unmatched) -
+               config.total_distance_penalty * static_cast<double>(metrics.total_unmatched_distance);
+    }
+};
+
+// Windows that touch at least one unmatched cell, most unmatched cells first.
+struct ImpactOrderedGenerator {
+    [[nodiscard]] static std::vector<Operation> generate(const BeamStackSearchConfig& config, const Field& field,
+                                                         const std::vector<Operation>& history,
+                                                         const PairMetrics& metrics);
+};
+
+// Every valid window in rotation-size order.
+struct ExhaustiveGenerator {
+    [[nodiscard]] static std::vector<Operation> generate(const BeamStackSearchConfig& config, const Field& field,
+                                                         const std::vector<Operation>& history,
+                                                         const PairMetrics& metrics);
+};
+
+// Best nodes in descending score order.
+struct PartialSortSelector {
+    template <typename Node>
+    static void keep_best(std::vector<Node>& nodes, std::size_t count) {
+        std::partial_sort(nodes.begin(), nodes.begin() + static_cast<std::ptrdiff_t>(count), nodes.end(),
+                          [](const Node& a, const Node& b) { return a.score > b.score; });
+        nodes.resize(count);
+    }
+};
+
+// Best nodes in no particular order; linear instead of n log k.
+struct NthElementSelector {
+    template <typename Node>
+    static void keep_best(std::vector<Node>& nodes, std::size_t count) {
+        std::nth_element(nodes.begin(), nodes.begin() + static_cast<std::ptrdiff_t>(count), nodes.end(),
+                         [](const Node& a, const Node& b) { return a.score > b.score; });
+        nodes.resize(count);
+    }
+};
+
+}  // namespace proc36
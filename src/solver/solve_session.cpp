@@ -0,0 +1,80 @@
+#include "solver/solve_session.hpp"
+
+#include <limits>
+#include <utility>
+
+#include "solver/decomposition.hpp"
+
+namespace proc36 {
+
+namespace {
+
+BeamStackSearchConfig with_cancel_flag(BeamStackSearchConfig config, const std::atomic<bool>* flag) {
+    config.cancel_flag = flag;
+    return config;
+}
+
+}  // namespace
+
+SolveSession::SolveSession(BeamStackSearchConfig config, Problem problem, std::vector<Operation> warm_start)
+    : problem_(std::move(problem)),
+      warm_start_(std::move(warm_start)),
+      solver_(with_cancel_flag(std::move(config), &cancelled_)) {
+    timer_.pause();
+    steps_ = solve_default_steps(solver_, problem_, warm_start_, timer_, result_);
+}
+
+void SolveSession::set_progress_callback(ProgressCallback callback) {
+    on_progress_ = std::move(callback);
+}
+
+bool SolveSession::step(double budget_ms) {
+    if (steps_.done()) {
+        return false;
+    }
+    timer_.resume();
+    const double deadline_ms = timer_.elapsed_ms() + budget_ms;
+    try {
+        while (steps_.next()) {
+            const auto& current = steps_.value();
+            {
+                std::lock_guard<std::mutex> lock(snapshot_mutex_);
+                snapshot_ = result_;
+                last_progress_ = current;
+            }
+            if (on_progress_) {
+                on_progress_(current);
+            }
+            if (current.phase == SolvePhase::Finished) {
+                steps_.next();  // lets the coroutine run off its end
+                break;
+            }
+            if (timer_.elapsed_ms() >= deadline_ms) {
+                break;
+            }
+        }
+    } catch (...) {
+        timer_.pause();
+        throw;
+    }
+    timer_.pause();
+    return !steps_.done();
+}
+
+BeamStackSearchResult SolveSession::run() {
+    while (step(std::numeric_limits<double>::infinity())) {
+    }
+    return best();
+}
+
+BeamStackSearchResult SolveSession::best() const {
+    std::lock_guard<std::mutex> lock(snapshot_mutex_);
+    return snapshot_;
+}
+
+SolveProgress SolveSession::progress() const {
+    std::lock_guard<std::mutex> lock(snapshot_mutex_);
+    return last_progress_;
+}
+
+}  // namespace proc36
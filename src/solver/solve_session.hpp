@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "lib/generator.hpp"
+#include "lib/operation.hpp"
+#include "lib/problem.hpp"
+#include "lib/timer.hpp"
+#include "solver/beam_stack_search.hpp"
+
+namespace proc36 {
+
+// A solve that advances in time slices. The time limit of the config counts only time spent inside step(), so a
+// caller can interleave several sessions on one thread or park one while another has priority. best() and cancel()
+// may be called from any thread; step() and run() from one thread at a time. Boards solve_default decomposes are
+// solved within a single step.
+class SolveSession {
+public:
+    using ProgressCallback = std::function<void(const SolveProgress&)>;
+
+    SolveSession(BeamStackSearchConfig config, Problem problem, std::vector<Operation> warm_start = {});
+    SolveSession(const SolveSession&) = delete;
+    SolveSession& operator=(const SolveSession&) = delete;
+
+    // Called on the stepping thread at every yield of the solve: search layers, refinement moves, shakes and phase
+    // changes.
+    void set_progress_callback(ProgressCallback callback);
+
+    // Runs for about `budget_ms` of solver time, stopping at the first yield of solve_steps past it (a search layer, a
+    // refinement move or a shake), so a step overruns the budget by at most one of those. Returns true while work
+    // remains.
+    bool step(double budget_ms);
+    // Steps until the solve finishes and returns its result.
+    BeamStackSearchResult run();
+
+    // Makes the running or next step wind down; the session then finishes with the best answer found so far.
+    void cancel() noexcept { cancelled_.store(true, std::memory_order_relaxed); }
+
+    [[nodiscard]] bool finished() const noexcept { return steps_.done(); }
+    [[nodiscard]] bool cancelled() const noexcept { return cancelled_.load(std::memory_order_relaxed); }
+    // Best answer as of the last layer boundary.
+    [[nodiscard]] BeamStackSearchResult best() const;
+    [[nodiscard]] SolveProgress progress() const;
+
+private:
+    std::atomic<bool> cancelled_{false};
+    Problem problem_;
+    std::vector<Operation> warm_start_;
+    BeamStackSearchSolver solver_;
+    Timer timer_;
+    BeamStackSearchResult result_;
+    Generator<SolveProgress> steps_;
+    ProgressCallback on_progress_;
+
+    mutable std::mutex snapshot_mutex_;
+    BeamStackSearchResult snapshot_;
+    SolveProgress last_progress_;
+};
+
+}  // namespace proc36
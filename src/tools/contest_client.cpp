@@ -0,0 +1,294 @@
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "lib/http.hpp"
+#include "lib/json.hpp"
+#include "lib/problem.hpp"
+#include "lib/thread_pool.hpp"
+#include "lib/timer.hpp"
+#include "solver/beam_stack_search.hpp"
+#include "solver/decomposition.hpp"
+
+namespace {
+
+constexpr const char* kUsage =
+    "Usage: contest_client --server URL [--token TOKEN] [--problem-path PATH] [--answer-path PATH]\n"
+    "                      [--poll-ms MS] [--min-interval-ms MS] [--max-submissions N] [--time-limit-ms MS]\n"
+    "                      [--threads N]\n";
+
+struct Options {
+    std::string server;
+    std::string token;
+    std::string problem_path = "/problem";
+    std::string answer_path = "/answer";
+    double poll_ms = 100.0;
+    double min_interval_ms = 1000.0;  // keeps submission traffic well below anything that looks like interference
+    std::size_t max_submissions = 30;
+    double time_limit_ms = -1.0;  // negative: size-class default
+    std::size_t threads = 1;
+};
+
+bool parse_options(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            return false;
+        }
+        const std::string value = argv[++i];
+        if (arg == "--server") {
+            options.server = value;
+        } else if (arg == "--token") {
+            options.token = value;
+        } else if (arg == "--problem-path") {
+            options.problem_path = value;
+        } else if (arg == "--answer-path") {
+            options.answer_path = value;
+        } else if (arg == "--poll-ms") {
+            options.poll_ms = std::stod(value);
+        } else if (arg == "--min-interval-ms") {
+            options.min_interval_ms = std::stod(value);
+        } else if (arg == "--max-submissions") {
+            options.max_submissions = static_cast<std::size_t>(std::stoul(value));
+        } else if (arg == "--time-limit-ms") {
+            options.time_limit_ms = std::stod(value);
+        } else if (arg == "--threads") {
+            options.threads = static_cast<std::size_t>(std::stoul(value));
+        } else {
+            return false;
+        }
+    }
+    return !options.server.empty();
+}
+
+double unix_now_ms() {
+    return std::chrono::duration<double, std::milli>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// Posts improved answers from a background thread so the solver never waits on the network. Submissions respect
+// the server's cap and a minimum interval; an answer waiting for its slot is replaced by any better one. Partial
+// answers never use the last slot while the solve runs, so a solved answer always has one left.
+class Submitter {
+public:
+    Submitter(proc36::HttpUrl url, proc36::HttpHeaders headers, const Options& options, const proc36::Timer& receipt)
+        : url_(std::move(url)),
+          headers_(std::move(headers)),
+          min_interval_ms_(options.min_interval_ms),
+          max_submissions_(options.max_submissions),
+          receipt_(receipt),
+          thread_([this]() { run(); }) {}
+
+    ~Submitter() { finish(); }
+
+    // Queues `answer` unless an answer at least as good is already pending or accepted by the server. Unsolved
+    // answers count too: they are ranked like results, so a partial answer still scores if nothing better comes.
+    void offer(const proc36::BeamStackSearchResult& answer) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (answer.operations.empty() || (best_submitted_ && !proc36::is_better_result(answer, *best_submitted_)) ||
+            (pending_ && !proc36::is_better_result(answer, *pending_))) {
+            return;
+        }
+        pending_ = slim(answer);
+        wake_.notify_all();
+    }
+
+    // Flushes the pending answer (waiting for its slot if necessary) and stops the thread.
+    void finish() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_all();
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+    [[nodiscard]] std::size_t submissions() const noexcept { return submissions_; }
+    [[nodiscard]] std::optional<double> first_submission_ms() const noexcept { return first_submission_ms_; }
+    [[nodiscard]] std::size_t best_submitted() const noexcept {
+        return best_submitted_ ? best_submitted_->operations.size() : 0;
+    }
+    [[nodiscard]] bool best_submitted_solved() const noexcept { return best_submitted_ && best_submitted_->solved; }
+
+private:
+    // Only what ranking and submitting need, so queued answers do not carry the search statistics along.
+    static proc36::BeamStackSearchResult slim(const proc36::BeamStackSearchResult& answer) {
+        proc36::BeamStackSearchResult copy;
+        copy.operations = answer.operations;
+        copy.status = answer.status;
+        copy.solved = answer.solved;
+        return copy;
+    }
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            wake_.wait(lock, [this]() { return stopping_ || pending_.has_value(); });
+            if (!pending_) {
+                return;  // stopping with nothing left to send
+            }
+            if (submissions_ >= max_submissions_) {
+                pending_.reset();
+                continue;
+            }
+            // The last slot is kept for a solved answer; a partial one takes it only when the solve ends unsolved.
+            if (!pending_->solved && submissions_ + 1 >= max_submissions_ && !stopping_) {
+                wake_.wait(lock, [this]() { return stopping_ || (pending_ && pending_->solved); });
+                continue;
+            }
+            if (attempted_) {
+                const double wait_ms = last_submission_ms_ + min_interval_ms_ - receipt_.elapsed_ms();
+                if (wait_ms > 0.0) {
+                    wake_.wait_for(lock, std::chrono::duration<double, std::milli>(wait_ms));
+                    continue;
+                }
+            }
+
+            auto answer = std::move(*pending_);
+            pending_.reset();
+            lock.unlock();
+            const auto body = "{\"ops\":" + proc36::json_ops_array(answer.operations) + "}";
+            int status = 0;
+            try {
+                status = proc36::http_request("POST", url_, body, headers_).status;
+            } catch (const std::exception& e) {
+                std::cerr << "submission failed: " << e.what() << '\n';
+            }
+            const double now_ms = receipt_.elapsed_ms();
+            lock.lock();
+
+            // Only an accepted answer uses up one of the server's submissions; a rejected or lost one is retried
+            // after the interval unless something better has been queued meanwhile or the client is shutting down.
+            last_submission_ms_ = now_ms;
+            attempted_ = true;
+            const bool accepted = status >= 200 && status < 300;
+            std::cout << "submitted " << answer.operations.size() << " ops (" << (answer.solved ? "solved" : "partial")
+                      << ") at " << now_ms << " ms (HTTP " << status << ")\n";
+            if (accepted) {
+                ++submissions_;
+                if (!first_submission_ms_) {
+                    first_submission_ms_ = now_ms;
+                }
+                if (!best_submitted_ || proc36::is_better_result(answer, *best_submitted_)) {
+                    best_submitted_ = std::move(answer);
+                }
+            } else if (!stopping_ && !pending_) {
+                pending_ = std::move(answer);
+            }
+        }
+    }
+
+    proc36::HttpUrl url_;
+    proc36::HttpHeaders headers_;
+    double min_interval_ms_;
+    std::size_t max_submissions_;
+    const proc36::Timer& receipt_;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::optional<proc36::BeamStackSearchResult> pending_;
+    bool stopping_ = false;
+    std::size_t submissions_ = 0;  // accepted by the server
+    bool attempted_ = false;
+    double last_submission_ms_ = 0.0;
+    std::optional<double> first_submission_ms_;
+    std::optional<proc36::BeamStackSearchResult> best_submitted_;
+    std::thread thread_;  // last, so it starts after every member it reads
+};
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    try {
+        Options options;
+        if (!parse_options(argc, argv, options)) {
+            std::cerr << kUsage;
+            return EXIT_FAILURE;
+        }
+
+        const auto server = proc36::HttpUrl::parse(options.server);
+        proc36::HttpHeaders headers;
+        if (!options.token.empty()) {
+            headers.emplace_back("Procon-Token", options.token);
+        }
+
+        // The problem is null until the match starts, so poll until the field appears.
+        proc36::HttpResponse response;
+        while (true) {
+            try {
+                response = proc36::http_request("GET", server.with_path(options.problem_path), {}, headers);
+                if (response.status == 200 && response.body.find("\"entities\"") != std::string::npos) {
+                    break;
+                }
+            } catch (const std::exception& e) {
+                std::cerr << "poll failed: " << e.what() << '\n';
+            }
+            std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(options.poll_ms));
+        }
+        const proc36::Timer receipt;
+
+        const auto problem = proc36::Problem::from_json_string(response.body);
+        const double parse_ms = receipt.elapsed_ms();
+        if (const auto starts_at = proc36::json_number_field(response.body, "startsAt"); starts_at && *starts_at > 0) {
+            const double wait_ms = *starts_at * 1000.0 - unix_now_ms();
+            if (wait_ms > 0.0) {
+                std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(wait_ms));
+            }
+        }
+        std::cout << "problem received: size " << problem.size << ", parsed in " << parse_ms << " ms\n";
+
+        auto config = proc36::make_default_config(problem.size);
+        if (options.time_limit_ms >= 0.0) {
+            config.time_limit_ms = options.time_limit_ms;
+        }
+        std::optional<proc36::ThreadPool> pool;
+        if (options.threads != 1) {
+            pool.emplace(options.threads);
+            config.thread_pool = &*pool;
+        }
+
+        Submitter submitter(server.with_path(options.answer_path), headers, options, receipt);
+        config.on_solution = [&submitter](const std::vector<proc36::Operation>& ops) {
+            proc36::BeamStackSearchResult answer;
+            answer.operations = ops;
+            answer.solved = true;
+            submitter.offer(answer);
+        };
+
+        // Stepping the solve lets the best answer, solved or not, go out at every layer boundary, so a match that
+        // ends before the board is solved still has its best partial answer on the server. A decomposed board
+        // yields only once, at the end.
+        proc36::BeamStackSearchSolver solver(config);
+        proc36::BeamStackSearchResult result;
+        proc36::Timer timer;
+        auto steps = proc36::solve_default_steps(solver, problem, {}, timer, result);
+        while (steps.next()) {
+            submitter.offer(result);
+        }
+        submitter.offer(result);
+        submitter.finish();
+
+        std::cout << "solver finished: " << (result.solved ? "SOLVED" : "PARTIAL") << ", "
+                  << result.operations.size() << " ops, " << result.elapsed_ms << " ms\n";
+        std::cout << "submissions: " << submitter.submissions() << ", best submitted: " << submitter.best_submitted()
+                  << " ops" << (submitter.best_submitted_solved() ? "" : " (partial)") << '\n';
+        if (const auto first = submitter.first_submission_ms()) {
+            std::cout << "receipt to first submission: " << *first << " ms\n";
+        } else {
+            std::cout << "receipt to first submission: none\n";
+        }
+        return EXIT_SUCCESS;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,161 @@
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "lib/http.hpp"
+#include "lib/json.hpp"
+#include "lib/problem.hpp"
+#include "lib/socket.hpp"
+#include "lib/timer.hpp"
+
+namespace {
+
+constexpr const char* kUsage =
+    "Usage: contest_mock_server --problem FILE [--port P] [--start-delay-ms MS] [--token TOKEN]\n"
+    "                           [--max-submissions N] [--exit-after N]\n";
+
+struct Options {
+    std::string problem_path;
+    std::uint16_t port = 8080;
+    double start_delay_ms = 1000.0;
+    std::string token;
+    std::size_t max_submissions = 30;
+    std::size_t exit_after = 0;  // 0 serves forever
+};
+
+bool parse_options(int argc, char** argv, Options& options) {
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const std::string arg = argv[i];
+        const std::string value = argv[i + 1];
+        if (arg == "--problem") {
+            options.problem_path = value;
+        } else if (arg == "--port") {
+            options.port = static_cast<std::uint16_t>(std::stoul(value));
+        } else if (arg == "--start-delay-ms") {
+            options.start_delay_ms = std::stod(value);
+        } else if (arg == "--token") {
+            options.token = value;
+        } else if (arg == "--max-submissions") {
+            options.max_submissions = static_cast<std::size_t>(std::stoul(value));
+        } else if (arg == "--exit-after") {
+            options.exit_after = static_cast<std::size_t>(std::stoul(value));
+        } else {
+            return false;
+        }
+    }
+    return argc % 2 == 1 && !options.problem_path.empty();
+}
+
+double unix_now_ms() {
+    return std::chrono::duration<double, std::milli>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+std::string read_file(const std::string& path) {
+    std::ifstream ifs(path);
+    if (!ifs) {
+        throw std::runtime_error("Failed to open problem file: " + path);
+    }
+    std::ostringstream oss;
+    oss << ifs.rdbuf();
+    return oss.str();
+}
+
+}  // namespace
+
+// Offline stand-in for the contest server: serves one problem from startsAt on and validates posted answers, logging
+// the delay between the first problem download and every submission.
+int main(int argc, char** argv) {
+    try {
+        Options options;
+        if (!parse_options(argc, argv, options)) {
+            std::cerr << kUsage;
+            return EXIT_FAILURE;
+        }
+
+        const auto file = read_file(options.problem_path);
+        const auto problem = proc36::Problem::from_json_string(file);
+        const auto problem_object = proc36::json_compound_field(file, "problem");
+        if (!problem_object) {
+            throw std::runtime_error("Problem file has no \"problem\" object");
+        }
+        const auto starts_at = static_cast<long long>(std::ceil((unix_now_ms() + options.start_delay_ms) / 1000.0));
+
+        const auto listener = proc36::Socket::listen_tcp(options.port, "127.0.0.1");
+        std::cout << "mock server on http://127.0.0.1:" << listener.local_port() << ", startsAt " << starts_at
+                  << std::endl;
+
+        std::optional<proc36::Timer> served;  // started when the problem is first handed out
+        std::size_t submissions = 0;
+        while (options.exit_after == 0 || submissions < options.exit_after) {
+            auto client = listener.accept();
+            proc36::HttpRequest request;
+            try {
+                if (!proc36::read_http_request(client, request)) {
+                    continue;
+                }
+                if (!options.token.empty()) {
+                    const auto it = request.headers.find("procon-token");
+                    if (it == request.headers.end() || it->second != options.token) {
+                        proc36::write_http_response(client, 401, "{\"error\":\"invalid token\"}");
+                        continue;
+                    }
+                }
+
+                if (request.method == "GET" && request.path == "/problem") {
+                    const bool started = unix_now_ms() >= static_cast<double>(starts_at) * 1000.0;
+                    if (started && !served) {
+                        served.emplace();
+                    }
+                    proc36::write_http_response(client, 200,
+                                                "{\"startsAt\":" + std::to_string(starts_at) + ",\"problem\":" +
+                                                    (started ? *problem_object : std::string("null")) + "}");
+                } else if (request.method == "POST" && request.path == "/answer") {
+                    if (submissions >= options.max_submissions) {
+                        proc36::write_http_response(client, 429, "{\"error\":\"submission limit reached\"}");
+                        continue;
+                    }
+                    ++submissions;
+                    const auto ops = proc36::Problem::parse_operations(request.body);
+                    auto field = problem.make_field();
+                    bool valid = true;
+                    for (const auto& op : ops) {
+                        if (!field.is_valid_operation(op)) {
+                            valid = false;
+                            break;
+                        }
+                        field.apply(op);
+                    }
+                    const auto status = field.evaluate_pairs();
+                    const double latency_ms = served ? served->elapsed_ms() : 0.0;
+                    std::cout << "answer #" << submissions << ": " << ops.size() << " ops, "
+                              << (valid && field.is_goal_state() ? "complete" : "incomplete") << ", " << latency_ms
+                              << " ms after problem served" << std::endl;
+                    proc36::write_http_response(
+                        client, valid ? 200 : 400,
+                        "{\"revision\":" + std::to_string(submissions) + ",\"valid\":" + (valid ? "true" : "false") +
+                            ",\"unmatched\":" + std::to_string(status.unmatched) + "}");
+                } else {
+                    proc36::write_http_response(client, 404, "{\"error\":\"not found\"}");
+                }
+            } catch (const std::exception& e) {
+                std::cerr << "request failed: " << e.what() << '\n';
+                try {
+                    proc36::write_http_response(client, 400,
+                                                "{\"error\":\"" + proc36::json_escape(e.what()) + "\"}");
+                } catch (const std::exception&) {
+                    // the client is gone as well
+                }
+            }
+        }
+        return EXIT_SUCCESS;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,460 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+#include "lib/http.hpp"
+#include "lib/json.hpp"
+#include "lib/problem.hpp"
+#include "lib/socket.hpp"
+#include "lib/symmetry.hpp"
+#include "lib/thread_pool.hpp"
+#include "lib/timer.hpp"
+#include "solver/beam_stack_search.hpp"
+#include "solver/decomposition.hpp"
+
+// One coordinator hands every connected worker slot its own assignment (a board rotation plus a beam width) and
+// relays each improved answer length to all workers as a shared bound. Messages are newline-delimited JSON over
+// TCP:
+//   worker -> coordinator  {"type":"hello","name":..,"slots":N}
+//   coordinator -> worker  {"type":"task","task_id":I,"symmetry":S,"beam_scale":X,"time_limit_ms":T,"problem":{..}}
+//   coordinator -> worker  {"type":"bound","length":L}
+//   worker -> coordinator  {"type":"solution","task_id":I,"ops":[..]}   (ops on the original board)
+//   worker -> coordinator  {"type":"partial","task_id":I,"ops":[..]}    (best unsolved answer of a task)
+//   worker -> coordinator  {"type":"done","task_id":I,"solved":..,"explored_nodes":..}
+
+namespace {
+
+constexpr const char* kUsage =
+    "Usage: distributed_solver coordinator --problem FILE [--port P] [--workers N] [--output FILE]\n"
+    "                                      [--time-limit-ms MS] [--submit URL] [--token TOKEN]\n"
+    "       distributed_solver worker --coordinator HOST:PORT [--slots N] [--threads N] [--name NAME]\n";
+constexpr std::uint16_t kDefaultPort = 47036;
+constexpr double kConnectTimeoutMs = 30'000.0;
+constexpr double kConnectRetryMs = 200.0;
+constexpr double kCoordinatorGraceMs = 3'000.0;  // slack past the time limit before stragglers are abandoned
+constexpr std::size_t kRotations = 4;            // only rotations keep answer lengths unchanged
+
+struct Options {
+    std::string mode;
+    std::string problem_path;
+    std::uint16_t port = kDefaultPort;
+    std::size_t workers = 1;
+    std::string output_path;
+    double time_limit_ms = -1.0;  // negative: size-class default
+    std::string submit_url;
+    std::string token;
+    std::string coordinator;
+    std::size_t slots = 1;
+    std::size_t threads = 0;  // 0: one per slot
+    std::string name;
+};
+
+bool parse_options(int argc, char** argv, Options& options) {
+    if (argc < 2) {
+        return false;
+    }
+    options.mode = argv[1];
+    for (int i = 2; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            return false;
+        }
+        const std::string value = argv[++i];
+        if (arg == "--problem") {
+            options.problem_path = value;
+        } else if (arg == "--port") {
+            options.port = static_cast<std::uint16_t>(std::stoul(value));
+        } else if (arg == "--workers") {
+            options.workers = static_cast<std::size_t>(std::stoul(value));
+        } else if (arg == "--output") {
+            options.output_path = value;
+        } else if (arg == "--time-limit-ms") {
+            options.time_limit_ms = std::stod(value);
+        } else if (arg == "--submit") {
+            options.submit_url = value;
+        } else if (arg == "--token") {
+            options.token = value;
+        } else if (arg == "--coordinator") {
+            options.coordinator = value;
+        } else if (arg == "--slots") {
+            options.slots = std::max<std::size_t>(1, static_cast<std::size_t>(std::stoul(value)));
+        } else if (arg == "--threads") {
+            options.threads = static_cast<std::size_t>(std::stoul(value));
+        } else if (arg == "--name") {
+            options.name = value;
+        } else {
+            return false;
+        }
+    }
+    if (options.mode == "coordinator") {
+        return !options.problem_path.empty() && options.workers > 0;
+    }
+    return options.mode == "worker" && !options.coordinator.empty();
+}
+
+// Lowers `bound` to `length` unless it already holds something at least as short.
+void tighten(std::atomic<std::size_t>& bound, std::size_t length) {
+    auto current = bound.load();
+    while ((current == 0 || length < current) && !bound.compare_exchange_weak(current, length)) {
+    }
+}
+
+// A socket whose whole-line writes are serialised; reads stay with the single thread that owns the connection.
+class Channel {
+public:
+    explicit Channel(proc36::Socket socket) : socket_(std::move(socket)) {}
+
+    void send(const std::string& line) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        try {
+            socket_.send_all(line + '\n');
+        } catch (const std::exception&) {
+            // the peer went away; its reader notices the closed stream
+        }
+    }
+
+    bool read_line(std::string& line) { return socket_.read_line(line); }
+    void close_write() const noexcept { socket_.shutdown_write(); }
+    void shutdown() const noexcept { socket_.shutdown(); }
+
+private:
+    proc36::Socket socket_;
+    std::mutex mutex_;
+};
+
+class Coordinator {
+public:
+    Coordinator(proc36::Problem problem, Options options) : problem_(std::move(problem)), options_(std::move(options)) {
+        time_limit_ms_ = options_.time_limit_ms >= 0.0 ? options_.time_limit_ms
+                                                       : proc36::make_default_config(problem_.size).time_limit_ms;
+    }
+
+    int run() {
+        const auto listener = proc36::Socket::listen_tcp(options_.port);
+        std::cout << "coordinator listening on port " << listener.local_port() << ", waiting for " << options_.workers
+                  << " workers\n";
+        for (std::size_t i = 0; i < options_.workers; ++i) {
+            auto worker = std::make_unique<Worker>(listener.accept());
+            std::string hello;
+            if (!worker->channel.read_line(hello) || proc36::json_string_field(hello, "type") != "hello") {
+                throw std::runtime_error("worker did not introduce itself");
+            }
+            worker->name = proc36::json_string_field(hello, "name").value_or("worker-" + std::to_string(i));
+            worker->slots = std::max<std::size_t>(1, static_cast<std::size_t>(
+                                                         proc36::json_number_field(hello, "slots").value_or(1.0)));
+            std::cout << "worker " << worker->name << " connected with " << worker->slots << " slots\n";
+            workers_.push_back(std::move(worker));
+        }
+
+        timer_.reset();
+        const auto problem_json = problem_.to_json_string();
+        std::size_t task_id = 0;
+        for (auto& worker : workers_) {
+            for (std::size_t slot = 0; slot < worker->slots; ++slot, ++task_id) {
+                std::ostringstream oss;
+                oss << "{\"type\":\"task\",\"task_id\":" << task_id << ",\"symmetry\":" << task_id % kRotations
+                    << ",\"beam_scale\":" << 1.0 + 0.5 * static_cast<double>(task_id / kRotations)
+                    << ",\"time_limit_ms\":" << time_limit_ms_ << ",\"problem\":" << problem_json << '}';
+                worker->channel.send(oss.str());
+            }
+            outstanding_ += worker->slots;
+        }
+
+        bool abandoned = false;
+        std::vector<std::thread> readers;
+        readers.reserve(workers_.size());
+        for (auto& worker : workers_) {
+            readers.emplace_back([this, &worker = *worker]() { read_worker(worker); });
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            const auto deadline = std::chrono::steady_clock::now() +
+                                  std::chrono::duration<double, std::milli>(time_limit_ms_ + kCoordinatorGraceMs);
+            if (!finished_.wait_until(lock, deadline, [this]() { return outstanding_ == 0; })) {
+                std::cout << "deadline reached with " << outstanding_ << " tasks outstanding\n";
+                abandoned = true;
+            }
+        }
+        // Stragglers are cut off entirely so their readers return now instead of whenever the workers give up.
+        for (auto& worker : workers_) {
+            if (abandoned) {
+                worker->channel.shutdown();
+            } else {
+                worker->channel.close_write();
+            }
+        }
+
+        proc36::BeamStackSearchResult best;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            best = best_;
+        }
+        if (best.operations.empty()) {
+            std::cout << "no worker reported an answer\n";
+        } else {
+            std::cout << "best answer: " << best.operations.size() << " ops"
+                      << (best.solved ? "" : " (partial, " + std::to_string(best.status.unmatched) + " unmatched)")
+                      << " after " << best_ms_ << " ms\n";
+            if (!options_.submit_url.empty()) {
+                submit(best.operations);
+            }
+        }
+        for (auto& reader : readers) {
+            reader.join();
+        }
+        return best.solved ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+private:
+    struct Worker {
+        explicit Worker(proc36::Socket socket) : channel(std::move(socket)) {}
+        Channel channel;
+        std::string name;
+        std::size_t slots = 1;
+        std::size_t done = 0;
+    };
+
+    void read_worker(Worker& worker) {
+        std::string line;
+        try {
+            while (worker.channel.read_line(line)) {
+                // A malformed line is dropped on its own; the worker's later reports are still read.
+                try {
+                    const auto type = proc36::json_string_field(line, "type");
+                    if (type == "solution" || type == "partial") {
+                        offer(worker, proc36::Problem::parse_operations(line));
+                    } else if (type == "done") {
+                        std::cout << "worker " << worker.name << " finished task "
+                                  << proc36::json_number_field(line, "task_id").value_or(-1.0) << " after "
+                                  << timer_.elapsed_ms() << " ms ("
+                                  << proc36::json_number_field(line, "explored_nodes").value_or(0.0) << " nodes)\n";
+                        complete(worker, 1);
+                    }
+                } catch (const std::exception& e) {
+                    std::cerr << "worker " << worker.name << " sent a bad line: " << e.what() << '\n';
+                }
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "worker " << worker.name << ": " << e.what() << '\n';
+        }
+        // A worker that disconnects early never reports its remaining tasks.
+        std::lock_guard<std::mutex> lock(mutex_);
+        complete_locked(worker, worker.slots - std::min(worker.slots, worker.done));
+    }
+
+    void complete(Worker& worker, std::size_t count) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        complete_locked(worker, count);
+    }
+
+    void complete_locked(Worker& worker, std::size_t count) {
+        count = std::min(count, worker.slots - std::min(worker.slots, worker.done));
+        worker.done += count;
+        outstanding_ -= count;
+        if (outstanding_ == 0) {
+            finished_.notify_all();
+        }
+    }
+
+    // Replays a reported answer on the original board and, when it beats the best so far (a solved answer beats
+    // any partial one), records it; a new shortest solved answer also has its length relayed to every worker.
+    void offer(const Worker& worker, std::vector<proc36::Operation> ops) {
+        if (ops.empty()) {
+            return;
+        }
+        auto field = problem_.make_field();
+        for (const auto& op : ops) {
+            if (!field.is_valid_operation(op)) {
+                std::cerr << "worker " << worker.name << " reported an answer with an invalid operation\n";
+                return;
+            }
+            field.apply(op);
+        }
+        proc36::BeamStackSearchResult answer;
+        answer.operations = std::move(ops);
+        answer.status = field.evaluate_pairs();
+        answer.solved = field.is_goal_state();
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!best_.operations.empty() && !proc36::is_better_result(answer, best_)) {
+            return;
+        }
+        best_ = std::move(answer);
+        best_ms_ = timer_.elapsed_ms();
+        std::cout << "new best " << best_.operations.size() << " ops" << (best_.solved ? "" : " (partial)") << " from "
+                  << worker.name << " at " << best_ms_ << " ms\n";
+        if (!options_.output_path.empty()) {
+            std::ofstream ofs(options_.output_path);
+            ofs << proc36::Problem::serialize_answer(best_.operations) << '\n';
+        }
+        if (!best_.solved) {
+            return;
+        }
+        const auto message = "{\"type\":\"bound\",\"length\":" + std::to_string(best_.operations.size()) + "}";
+        for (auto& other : workers_) {
+            other->channel.send(message);
+        }
+    }
+
+    void submit(const std::vector<proc36::Operation>& ops) const {
+        proc36::HttpHeaders headers;
+        if (!options_.token.empty()) {
+            headers.emplace_back("Procon-Token", options_.token);
+        }
+        try {
+            const auto response = proc36::http_request("POST", proc36::HttpUrl::parse(options_.submit_url),
+                                                       "{\"ops\":" + proc36::json_ops_array(ops) + "}", headers);
+            std::cout << "submitted " << ops.size() << " ops (HTTP " << response.status << ")\n";
+        } catch (const std::exception& e) {
+            std::cerr << "submission failed: " << e.what() << '\n';
+        }
+    }
+
+    proc36::Problem problem_;
+    Options options_;
+    double time_limit_ms_ = 0.0;
+    proc36::Timer timer_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+
+    std::mutex mutex_;
+    std::condition_variable finished_;
+    std::size_t outstanding_ = 0;
+    proc36::BeamStackSearchResult best_;  // operations, status and solved only
+    double best_ms_ = 0.0;
+};
+
+proc36::Socket connect_with_retry(const proc36::HttpUrl& address) {
+    const proc36::Timer timer;
+    while (true) {
+        try {
+            return proc36::Socket::connect_tcp(address.host, address.port);
+        } catch (const std::exception&) {
+            if (timer.elapsed_ms() > kConnectTimeoutMs) {
+                throw;
+            }
+            std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(kConnectRetryMs));
+        }
+    }
+}
+
+// Runs the coordinator's assignments on a local pool; every slot's solve also reads the bound relayed from the
+// other machines, so a shorter answer found anywhere prunes the search everywhere.
+int run_worker(const Options& options) {
+    auto address = proc36::HttpUrl::parse(options.coordinator);
+    if (options.coordinator.find(':') == std::string::npos) {
+        address.port = kDefaultPort;
+    }
+    Channel channel(connect_with_retry(address));
+    const auto name = options.name.empty() ? address.host + "-" + std::to_string(::getpid()) : options.name;
+    channel.send("{\"type\":\"hello\",\"name\":\"" + proc36::json_escape(name) +
+                 "\",\"slots\":" + std::to_string(options.slots) + "}");
+
+    proc36::ThreadPool pool(options.threads > 0 ? options.threads : options.slots);
+    std::atomic<std::size_t> bound{0};
+    std::mutex idle_mutex;
+    std::condition_variable idle;
+    std::size_t in_flight = 0;
+
+    auto run_task = [&](const std::string& line) {
+        const auto task_id = static_cast<std::size_t>(proc36::json_number_field(line, "task_id").value_or(0.0));
+        const auto symmetry = proc36::kAllSymmetries[static_cast<std::size_t>(
+                                                         proc36::json_number_field(line, "symmetry").value_or(0.0)) %
+                                                     kRotations];
+        const auto problem = proc36::Problem::from_json_string(proc36::json_compound_field(line, "problem").value());
+
+        auto config = proc36::make_default_config(problem.size);
+        const double scale = std::max(1.0, proc36::json_number_field(line, "beam_scale").value_or(1.0));
+        config.beam_width = static_cast<std::size_t>(static_cast<double>(config.beam_width) * scale);
+        config.beam_width_cap = std::max(config.beam_width_cap, config.beam_width);
+        if (auto limit = proc36::json_number_field(line, "time_limit_ms")) {
+            config.time_limit_ms = *limit;
+        }
+        config.thread_pool = &pool;
+        config.shared_length_bound = &bound;
+        const auto prefix = ",\"task_id\":" + std::to_string(task_id);
+        config.on_solution = [&, symmetry, prefix](const std::vector<proc36::Operation>& ops) {
+            tighten(bound, ops.size());
+            const auto mapped = proc36::transform_operations(ops, problem.size, proc36::inverse(symmetry));
+            channel.send("{\"type\":\"solution\"" + prefix + ",\"ops\":" + proc36::json_ops_array(mapped) + "}");
+        };
+
+        const auto result = proc36::solve_default(proc36::transform_problem(problem, symmetry), config);
+        if (!result.solved && !result.operations.empty()) {
+            const auto mapped =
+                proc36::transform_operations(result.operations, problem.size, proc36::inverse(symmetry));
+            channel.send("{\"type\":\"partial\"" + prefix + ",\"ops\":" + proc36::json_ops_array(mapped) + "}");
+        }
+        std::ostringstream oss;
+        oss << "{\"type\":\"done\"" << prefix << ",\"solved\":" << (result.solved ? "true" : "false")
+            << ",\"operations\":" << result.operations.size() << ",\"explored_nodes\":" << result.explored_nodes
+            << '}';
+        channel.send(oss.str());
+        std::cout << "task " << task_id << " (" << proc36::to_string(symmetry) << ", beam " << config.beam_width
+                  << "): " << (result.solved ? "SOLVED" : "PARTIAL") << ", " << result.operations.size()
+                  << " ops\n";
+    };
+
+    std::string line;
+    while (channel.read_line(line)) {
+        const auto type = proc36::json_string_field(line, "type");
+        if (type == "bound") {
+            tighten(bound, static_cast<std::size_t>(proc36::json_number_field(line, "length").value_or(0.0)));
+        } else if (type == "task") {
+            {
+                std::lock_guard<std::mutex> lock(idle_mutex);
+                ++in_flight;
+            }
+            pool.submit([&, line]() {
+                try {
+                    run_task(line);
+                } catch (const std::exception& e) {
+                    std::cerr << "task failed: " << e.what() << '\n';
+                    channel.send("{\"type\":\"done\",\"solved\":false}");
+                }
+                std::lock_guard<std::mutex> lock(idle_mutex);
+                if (--in_flight == 0) {
+                    idle.notify_all();
+                }
+            });
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(idle_mutex);
+    idle.wait(lock, [&]() { return in_flight == 0; });
+    return EXIT_SUCCESS;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    try {
+        Options options;
+        if (!parse_options(argc, argv, options)) {
+            std::cerr << kUsage;
+            return EXIT_FAILURE;
+        }
+        if (options.mode == "worker") {
+            return run_worker(options);
+        }
+        Coordinator coordinator(proc36::Problem::load_from_file(options.problem_path), options);
+        return coordinator.run();
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+}
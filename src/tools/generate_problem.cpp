@@ -1,10 +1,12 @@
-#include <algorithm>
+#include <cstdint>
 #include <fstream>
 #include <iostream>
 #include <random>
 #include <string>
 #include <vector>
 
+#include "lib/problem.hpp"
+
 int main(int argc, char** argv) {
     try {
         if (argc < 3 || argc > 4) {
@@ -13,8 +15,9 @@ int main(int argc, char** argv) {
         }
 
         const int size = std::stoi(argv[1]);
-        if (size % 2 != 0 || size < 4 || size > 24) {
-            std::cerr << "Size must be an even integer between 4 and 24.\n";
+        // Contest boards stop at 24; larger ones are for stress-testing how the solver scales.
+        if (size % 2 != 0 || size < 4 || size > 256) {
+            std::cerr << "Size must be an even integer between 4 and 256.\n";
             return 1;
         }
 
@@ -23,17 +26,7 @@ int main(int argc, char** argv) {
             seed = static_cast<std::uint64_t>(std::stoull(argv[3]));
         }
 
-        const std::size_t cell_count = static_cast<std::size_t>(size) * static_cast<std::size_t>(size);
-        const std::size_t pair_count = cell_count / 2;
-
-        std::vector<int> values(cell_count);
-        for (std::size_t v = 0; v < pair_count; ++v) {
-            values[2 * v] = static_cast<int>(v);
-            values[2 * v + 1] = static_cast<int>(v);
-        }
-
-        std::mt19937_64 rng(seed);
-        std::shuffle(values.begin(), values.end(), rng);
+        const auto values = proc36::Problem::random(static_cast<std::size_t>(size), seed).entities;
 
         std::ofstream ofs(argv[2]);
         if (!ofs) {
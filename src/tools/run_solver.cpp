@@ -1,10 +1,21 @@
+#include <array>
 #include <fstream>
 #include <iostream>
+#include <optional>
 #include <stdexcept>
 #include <string>
+#include <vector>
 
+#include "lib/allocation_stats.hpp"
+#include "lib/json.hpp"
+#include "lib/memory_budget.hpp"
 #include "lib/problem.hpp"
+#include "lib/solution_cache.hpp"
+#include "lib/thread_pool.hpp"
 #include "solver/beam_stack_search.hpp"
+#include "solver/config_table.hpp"
+#include "solver/decomposition.hpp"
+#include "solver/orientation_portfolio.hpp"
 
 namespace {
 
@@ -16,57 +27,321 @@ void write_ops_to_file(const std::string& path, const std::vector<proc36::Operat
     ofs << proc36::Problem::serialize_answer(ops) << '\n';
 }
 
+proc36::BeamStackSearchResult replay_result(const proc36::Problem& problem, std::vector<proc36::Operation> ops) {
+    auto field = problem.make_field();
+    for (const auto& op : ops) {
+        field.apply(op);
+    }
+    proc36::BeamStackSearchResult result;
+    result.status = field.evaluate_pairs();
+    result.solved = field.is_goal_state();
+    result.operations = std::move(ops);
+    return result;
+}
+
+double to_megabytes(std::size_t bytes) {
+    return static_cast<double>(bytes) / (1024.0 * 1024.0);
+}
+
+void print_phase_counts(const std::array<proc36::AllocationCounts, proc36::kAllocationPhaseCount>& phases) {
+    const char* separator = " ";
+    for (std::size_t phase = 0; phase < phases.size(); ++phase) {
+        const auto& counts = phases[phase];
+        if (counts.allocations == 0 && counts.frees == 0) {
+            continue;
+        }
+        std::cout << separator << proc36::to_string(static_cast<proc36::AllocationPhase>(phase)) << ' '
+                  << counts.allocations << " / " << to_megabytes(counts.bytes) << " MB (" << counts.frees
+                  << " frees)";
+        separator = ", ";
+    }
+}
+
+// Totals per phase with the solver's allocations per explored node, then one line per thread. "other" is everything
+// outside a solve, such as reading the problem.
+void print_allocations(std::size_t explored_nodes) {
+    const auto threads = proc36::allocation_snapshot();
+    std::array<proc36::AllocationCounts, proc36::kAllocationPhaseCount> totals{};
+    for (const auto& thread : threads) {
+        for (std::size_t phase = 0; phase < totals.size(); ++phase) {
+            totals[phase].allocations += thread.phases[phase].allocations;
+            totals[phase].bytes += thread.phases[phase].bytes;
+            totals[phase].frees += thread.phases[phase].frees;
+        }
+    }
+    std::uint64_t solver_allocations = 0;
+    for (std::size_t phase = 0; phase < totals.size(); ++phase) {
+        if (static_cast<proc36::AllocationPhase>(phase) != proc36::AllocationPhase::Other) {
+            solver_allocations += totals[phase].allocations;
+        }
+    }
+    std::cout << "  allocations:";
+    print_phase_counts(totals);
+    std::cout << '\n';
+    std::cout << "  allocations per explored node: "
+              << (explored_nodes > 0 ? static_cast<double>(solver_allocations) / static_cast<double>(explored_nodes)
+                                     : 0.0)
+              << '\n';
+    for (const auto& thread : threads) {
+        std::cout << "    thread " << thread.thread << ":";
+        print_phase_counts(thread.phases);
+        std::cout << '\n';
+    }
+}
+
+// One object per run, so a fleet of solvers can be aggregated line by line.
+void write_stats_json(const std::string& path, const std::string& problem_path,
+                      const proc36::BeamStackSearchResult& result) {
+    std::ofstream ofs(path);
+    if (!ofs) {
+        throw std::runtime_error("Failed to open stats file: " + path);
+    }
+    const auto& stats = result.stats;
+    ofs << "{\"problem\":\"" << proc36::json_escape(problem_path) << "\",\"solved\":"
+        << (result.solved ? "true" : "false") << ",\"operations\":" << result.operations.size()
+        << ",\"unmatched\":" << result.status.unmatched << ",\"elapsed_ms\":" << result.elapsed_ms
+        << ",\"overshoot_ms\":" << stats.overshoot_ms << ",\"explored_nodes\":" << result.explored_nodes
+        << ",\"nodes\":{\"search\":" << stats.search_nodes << ",\"shake\":" << stats.shake_nodes
+        << ",\"refinement\":" << stats.refinement_nodes << ",\"shortening\":" << stats.shortening_nodes
+        << "},\"duplicate_hits\":" << stats.duplicate_hits << ",\"duplicate_misses\":" << stats.duplicate_misses
+        << ",\"visited_clears\":" << stats.visited_clears << ",\"iterations\":" << stats.iterations
+        << ",\"shakes_accepted\":" << stats.shakes_accepted << ",\"bound_rejections\":" << stats.bound_rejections
+        << ",\"delta_rejections\":" << stats.delta_rejections << ",\"improvements\":[";
+    for (std::size_t i = 0; i < stats.improvements.size(); ++i) {
+        const auto& point = stats.improvements[i];
+        ofs << (i == 0 ? "" : ",") << "{\"elapsed_ms\":" << point.elapsed_ms << ",\"operations\":" << point.operations
+            << ",\"unmatched\":" << point.unmatched << ",\"solved\":" << (point.solved ? "true" : "false") << '}';
+    }
+    ofs << "]}\n";
+}
+
+constexpr const char* kUsage =
+    "Usage: beam_solver [--config TABLE] [--orientations N] [--canonical-hash] [--cache DIR [--improve]] "
+    "[--warm-start ops.json] [--lns-ms MS] [--threads N [--pin] [--pipelined]] [--shake-tournament N] "
+    "[--bandit BUDGET] [--lookahead WEIGHT] [--lock-edges] [--incremental] [--candidate-limit N] [--no-early-rejection] "
+    "[--regions N | --whole-board] [--memory-mb MB] [--stats-json PATH] <problem.json> [output.json]\n";
+
+struct Options {
+    std::string problem_path;
+    std::string output_path;
+    std::string config_path;  // per-size table written by tune_config; empty uses make_default_config
+    std::size_t orientations = 1;
+    bool canonical_hash = false;
+    std::string cache_dir;
+    bool improve = false;  // keep solving after a cache hit
+    std::string warm_start_path;
+    double lns_ms = -1.0;  // negative: solver default, or the whole time limit when warm starting
+    std::size_t threads = 1;  // 1 keeps the search on the calling thread
+    bool pin_threads = false;
+    bool pipelined = false;
+    std::size_t shake_tournament = 0;  // 0: solver default (one shake chain at a time)
+    std::size_t bandit_budget = 0;     // 0: every generated candidate is evaluated
+    double lookahead_weight = 0.0;     // 0: keeps the configured one_rotation_weight
+    bool lock_edges = false;
+    bool incremental = false;
+    std::size_t candidate_limit = 0;  // 0: keeps the configured candidate_limit
+    bool no_early_rejection = false;
+    std::optional<std::size_t> splits;  // regions per side; unset: solve_default's choice, 0: whole board
+    std::size_t memory_mb = 0;  // 0: no ceiling, usage is still reported
+    std::string stats_path;     // empty: no stats file
+};
+
+bool parse_options(int argc, char** argv, Options& options) {
+    std::vector<std::string> positional;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--config" && i + 1 < argc) {
+            options.config_path = argv[++i];
+        } else if (arg == "--orientations" && i + 1 < argc) {
+            options.orientations = static_cast<std::size_t>(std::stoul(argv[++i]));
+        } else if (arg == "--canonical-hash") {
+            options.canonical_hash = true;
+        } else if (arg == "--cache" && i + 1 < argc) {
+            options.cache_dir = argv[++i];
+        } else if (arg == "--improve") {
+            options.improve = true;
+        } else if (arg == "--warm-start" && i + 1 < argc) {
+            options.warm_start_path = argv[++i];
+        } else if (arg == "--lns-ms" && i + 1 < argc) {
+            options.lns_ms = std::stod(argv[++i]);
+        } else if (arg == "--threads" && i + 1 < argc) {
+            options.threads = static_cast<std::size_t>(std::stoul(argv[++i]));
+        } else if (arg == "--pin") {
+            options.pin_threads = true;
+        } else if (arg == "--pipelined") {
+            options.pipelined = true;
+        } else if (arg == "--shake-tournament" && i + 1 < argc) {
+            options.shake_tournament = static_cast<std::size_t>(std::stoul(argv[++i]));
+        } else if (arg == "--bandit" && i + 1 < argc) {
+            options.bandit_budget = static_cast<std::size_t>(std::stoul(argv[++i]));
+        } else if (arg == "--lookahead" && i + 1 < argc) {
+            options.lookahead_weight = std::stod(argv[++i]);
+        } else if (arg == "--lock-edges") {
+            options.lock_edges = true;
+        } else if (arg == "--incremental") {
+            options.incremental = true;
+        } else if (arg == "--candidate-limit" && i + 1 < argc) {
+            options.candidate_limit = static_cast<std::size_t>(std::stoul(argv[++i]));
+        } else if (arg == "--no-early-rejection") {
+            options.no_early_rejection = true;
+        } else if (arg == "--regions" && i + 1 < argc) {
+            options.splits = static_cast<std::size_t>(std::stoul(argv[++i]));
+        } else if (arg == "--whole-board") {
+            options.splits = 0;
+        } else if (arg == "--memory-mb" && i + 1 < argc) {
+            options.memory_mb = static_cast<std::size_t>(std::stoul(argv[++i]));
+        } else if (arg == "--stats-json" && i + 1 < argc) {
+            options.stats_path = argv[++i];
+        } else if (arg.rfind("--", 0) == 0) {
+            return false;
+        } else {
+            positional.push_back(arg);
+        }
+    }
+    if (positional.empty() || positional.size() > 2) {
+        return false;
+    }
+    options.problem_path = positional[0];
+    if (positional.size() == 2) {
+        options.output_path = positional[1];
+    }
+    return true;
+}
+
 }  // namespace
 
 int main(int argc, char** argv) {
     try {
-        if (argc < 2 || argc > 3) {
-            std::cerr << "Usage: beam_solver <problem.json> [output.json]\n";
+        Options options;
+        if (!parse_options(argc, argv, options)) {
+            std::cerr << kUsage;
             return 1;
         }
 
-        const std::string problem_path = argv[1];
-        const auto problem = proc36::Problem::load_from_file(problem_path);
+        const auto problem = proc36::Problem::load_from_file(options.problem_path);
 
-        proc36::BeamStackSearchConfig config;
-        if (problem.size > 8) {
-            config.rotation_sizes = {2, 3, 4, 5};
-            config.beam_width = 96;
-            config.max_depth = 28;
-            config.max_children_per_node = 48;
-            config.operation_penalty = 0.05;
-            config.time_limit_ms = 4800.0;
+        auto config = options.config_path.empty()
+                          ? proc36::make_default_config(problem.size)
+                          : proc36::ConfigTable::load_from_file(options.config_path).config_for(problem.size);
+        config.canonical_hashing = options.canonical_hash;
+        if (options.bandit_budget > 0) {
+            config.bandit_candidate_budget = options.bandit_budget;
+        }
+        config.lock_completed_edges = config.lock_completed_edges || options.lock_edges;
+        config.incremental_metrics = config.incremental_metrics || options.incremental;
+        config.early_rejection = config.early_rejection && !options.no_early_rejection;
+        if (options.candidate_limit > 0) {
+            config.candidate_limit = options.candidate_limit;
+        }
+        if (options.lookahead_weight != 0.0) {
+            config.one_rotation_weight = options.lookahead_weight;
         }
-        if (problem.size >= 16) {
-            config.rotation_sizes = {2, 3, 4, 5, 6};
-            config.beam_width = 128;
-            config.max_depth = 40;
-            config.max_nodes = 200'000;
-            config.max_children_per_node = 64;
-            config.operation_penalty = 0.03;
+        if (options.shake_tournament > 0) {
+            config.shake_tournament_size = options.shake_tournament;
         }
-        if (problem.size >= 22) {
-            config.beam_width = 160;
-            config.max_depth = 48;
-            config.max_nodes = 300'000;
-            config.time_limit_ms = 4900.0;
-            config.operation_penalty = 0.02;
+        proc36::MemoryBudget memory(options.memory_mb * 1024 * 1024);
+        config.memory_budget = &memory;
+
+        std::optional<proc36::ThreadPool> pool;
+        if (options.threads != 1) {
+            pool.emplace(options.threads, options.pin_threads);
+            config.thread_pool = &*pool;
+            config.pipelined_layers = options.pipelined;
         }
 
-        proc36::BeamStackSearchSolver solver(config);
-        const auto result = solver.solve(problem);
+        std::optional<proc36::SolutionCache> cache;
+        std::optional<proc36::BeamStackSearchResult> cached;
+        if (!options.cache_dir.empty()) {
+            cache.emplace(options.cache_dir);
+            if (auto ops = cache->lookup(problem)) {
+                cached = replay_result(problem, std::move(*ops));
+                std::cout << "Cache hit: " << cached->operations.size() << " operations\n";
+            }
+            config.on_solution = [&](const std::vector<proc36::Operation>& ops) {
+                if (cache->store(problem, ops)) {
+                    std::cout << "Cached new best: " << ops.size() << " operations\n";
+                }
+            };
+        }
+
+        std::vector<proc36::Operation> warm_start;
+        if (!options.warm_start_path.empty()) {
+            warm_start = proc36::Problem::load_operations_from_file(options.warm_start_path);
+            std::cout << "Warm start: " << warm_start.size() << " operations\n";
+        }
+        if (cached && (warm_start.empty() || cached->operations.size() < warm_start.size())) {
+            warm_start = cached->operations;
+        }
+        if (options.lns_ms >= 0.0) {
+            config.lns_time_budget_ms = options.lns_ms;
+        } else if (!warm_start.empty()) {
+            config.lns_time_budget_ms = config.time_limit_ms;
+        }
+
+        proc36::BeamStackSearchResult result;
+        if (cached && !options.improve) {
+            result = *cached;
+        } else {
+            if (options.orientations > 1) {
+                result = proc36::solve_orientations(problem, config, options.orientations, warm_start);
+            } else if (options.splits && *options.splits > 0 && warm_start.empty()) {
+                std::cout << "Solving " << *options.splits << "x" << *options.splits << " regions\n";
+                result = proc36::solve_decomposed(problem, config, *options.splits);
+            } else {
+                // Without --regions or --whole-board the choice is solve_default's, as in every other tool.
+                proc36::BeamStackSearchSolver solver(config);
+                result = options.splits ? solver.solve(problem, warm_start)
+                                        : proc36::solve_default(solver, problem, warm_start);
+                if (const auto* bandit = solver.rotation_bandit()) {
+                    std::cout << "Rotation bandit (size: children, mean reward):";
+                    for (std::size_t arm = 0; arm < bandit->sizes().size(); ++arm) {
+                        std::cout << ' ' << bandit->sizes()[arm] << ": " << bandit->pulls(arm) << ", "
+                                  << bandit->mean_reward(arm) << ';';
+                    }
+                    std::cout << '\n';
+                }
+            }
+            if (cached && !proc36::is_better_result(result, *cached)) {
+                const auto explored = result.explored_nodes;
+                const auto elapsed = result.elapsed_ms;
+                auto stats = std::move(result.stats);
+                result = *cached;
+                result.explored_nodes = explored;
+                result.elapsed_ms = elapsed;
+                result.stats = std::move(stats);
+            }
+        }
 
         std::cout << "BeamStackSearch result:\n";
         std::cout << "  explored nodes: " << result.explored_nodes << '\n';
         std::cout << "  elapsed ms: " << result.elapsed_ms << '\n';
+        if (proc36::allocation_tracking_enabled()) {
+            print_allocations(result.explored_nodes);
+        }
         std::cout << "  matched pairs: " << result.status.matched << '\n';
         std::cout << "  unmatched pairs: " << result.status.unmatched << '\n';
         std::cout << "  operations: " << result.operations.size() << '\n';
         std::cout << (result.solved ? "  status: SOLVED" : "  status: PARTIAL") << '\n';
+        std::cout << "  memory peak: " << to_megabytes(memory.peak()) << " MB (";
+        for (const auto component : {proc36::MemoryComponent::Layers, proc36::MemoryComponent::Expansion,
+                                     proc36::MemoryComponent::VisitedSet}) {
+            std::cout << (component == proc36::MemoryComponent::Layers ? "" : ", ") << proc36::to_string(component)
+                      << ' ' << to_megabytes(memory.peak(component));
+        }
+        std::cout << ")";
+        if (memory.limit() > 0) {
+            std::cout << ", " << memory.evictions() << " evictions, " << memory.beam_shrinks() << " beam shrinks";
+        }
+        std::cout << '\n';
+
+        if (!options.stats_path.empty()) {
+            write_stats_json(options.stats_path, options.problem_path, result);
+            std::cout << "Stats written to " << options.stats_path << '\n';
+        }
 
-        if (argc == 3) {
-            write_ops_to_file(argv[2], result.operations);
-            std::cout << "Operations written to " << argv[2] << '\n';
+        if (!options.output_path.empty()) {
+            write_ops_to_file(options.output_path, result.operations);
+            std::cout << "Operations written to " << options.output_path << '\n';
         } else {
             std::cout << "Serialized answer:\n";
             std::cout << proc36::Problem::serialize_answer(result.operations) << '\n';
@@ -0,0 +1,595 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "lib/field.hpp"
+#include "lib/pair_index.hpp"
+#include "lib/problem.hpp"
+#include "lib/random.hpp"
+#include "lib/rotation_reach.hpp"
+#include "lib/thread_pool.hpp"
+#include "lib/timer.hpp"
+#include "solver/beam_stack_search.hpp"
+#include "solver/decomposition.hpp"
+
+namespace {
+
+constexpr const char* kUsage =
+    "Usage: solver_bench pool [threads]\n"
+    "       solver_bench policies [size] [time_ms] [problems]\n"
+    "       solver_bench pipeline [threads] [size] [time_ms] [problems]\n"
+    "       solver_bench refinement [threads] [size] [budget_ms] [problems]\n"
+    "       solver_bench bandit [size] [time_ms] [problems] [budget]\n"
+    "       solver_bench lookahead [size] [time_ms] [problems] [weight]\n"
+    "       solver_bench decompose [size] [time_ms] [problems] [splits, default by size]\n"
+    "       solver_bench locking [size] [time_ms] [problems]\n"
+    "       solver_bench scaling [time_ms] [problems] [candidate_limit]\n"
+    "       solver_bench anytime [time_ms] [problems] [seeds] [sizes...]\n"
+    "       solver_bench screening [time_ms] [problems] [sizes...]\n";
+
+proc36::Problem random_problem(std::size_t size, proc36::Random& random) {
+    return proc36::Problem::random(size, random.next_int<std::uint64_t>(0, std::numeric_limits<std::uint64_t>::max()));
+}
+
+proc36::Field random_field(std::size_t size, proc36::Random& random) {
+    return random_problem(size, random).make_field();
+}
+
+// Work comparable to expanding one beam parent: apply and score a batch of rotations.
+std::size_t expand_like(const proc36::Field& parent, std::size_t children) {
+    std::size_t matched = 0;
+    for (std::size_t i = 0; i < children; ++i) {
+        const auto k = 2 + i % 5;
+        const proc36::Operation op{i % (parent.size() - k + 1), (i / 7) % (parent.size() - k + 1), k};
+        const auto child = parent.applied(op);
+        matched += child.evaluate_pair_metrics().status.matched;
+    }
+    return matched;
+}
+
+void bench_pool(std::size_t threads) {
+    proc36::ThreadPool pool(threads);
+    std::cout << "thread pool: " << pool.size() << " workers\n";
+    std::cout << std::fixed << std::setprecision(1);
+
+    {
+        constexpr std::size_t kTasks = 200'000;
+        std::atomic<std::size_t> counter{0};
+        proc36::Timer timer;
+        proc36::TaskGroup group(pool);
+        for (std::size_t i = 0; i < kTasks; ++i) {
+            group.run([&counter]() { counter.fetch_add(1, std::memory_order_relaxed); });
+        }
+        group.wait();
+        std::cout << "  empty task fork/join: " << timer.elapsed_ms() * 1e6 / kTasks << " ns/task\n";
+    }
+
+    for (const std::size_t grain : {1UL, 8UL, 64UL}) {
+        constexpr std::size_t kItems = 200'000;
+        std::vector<std::size_t> out(kItems);
+        proc36::Timer timer;
+        pool.parallel_for(0, kItems, grain, [&out](std::size_t i) { out[i] = i * 2; });
+        std::cout << "  parallel_for grain " << grain << ": " << timer.elapsed_ms() * 1e6 / kItems << " ns/item\n";
+    }
+
+    proc36::Random random(42);
+    for (const std::size_t size : {8UL, 16UL, 24UL}) {
+        constexpr std::size_t kParents = 160;
+        constexpr std::size_t kChildren = 64;
+        std::vector<proc36::Field> parents;
+        for (std::size_t i = 0; i < kParents; ++i) {
+            parents.push_back(random_field(size, random));
+        }
+        std::vector<std::size_t> sink(kParents);
+
+        proc36::Timer sequential;
+        for (std::size_t i = 0; i < kParents; ++i) {
+            sink[i] = expand_like(parents[i], kChildren);
+        }
+        const double sequential_ms = sequential.elapsed_ms();
+
+        proc36::Timer parallel;
+        pool.parallel_for(0, kParents, 1, [&](std::size_t i) { sink[i] = expand_like(parents[i], kChildren); });
+        const double parallel_ms = parallel.elapsed_ms();
+
+        std::cout << "  per-parent tasks n=" << size << ": sequential " << sequential_ms << " ms, parallel "
+                  << parallel_ms << " ms, " << sequential_ms * 1e3 / kParents << " us/parent\n";
+    }
+}
+
+// `solve(problem, config)` runs one problem under the default config of its size with the given time limit.
+template <typename Solve>
+void bench_runs(const char* name, const std::vector<proc36::Problem>& problems, double time_ms, Solve solve) {
+    std::size_t solved = 0;
+    std::size_t solved_ops = 0;
+    std::size_t unmatched = 0;
+    std::size_t nodes = 0;
+    double elapsed_ms = 0.0;
+    for (const auto& problem : problems) {
+        auto config = proc36::make_default_config(problem.size);
+        config.time_limit_ms = time_ms;
+        const auto result = solve(problem, config);
+        if (result.solved) {
+            ++solved;
+            solved_ops += result.operations.size();
+        }
+        unmatched += result.status.unmatched;
+        nodes += result.explored_nodes;
+        elapsed_ms += result.elapsed_ms;
+    }
+    const auto count = static_cast<double>(problems.size());
+    std::cout << "  " << std::left << std::setw(12) << name << std::right << " solved " << solved << "/"
+              << problems.size() << ", mean ops (solved) "
+              << (solved > 0 ? static_cast<double>(solved_ops) / static_cast<double>(solved) : 0.0)
+              << ", mean unmatched " << static_cast<double>(unmatched) / count << ", "
+              << static_cast<double>(nodes) / elapsed_ms << " nodes/ms\n";
+}
+
+template <typename Solver, typename Configure>
+void bench_policy(const char* name, const std::vector<proc36::Problem>& problems, double time_ms,
+                  Configure configure) {
+    bench_runs(name, problems, time_ms, [&](const proc36::Problem& problem, proc36::BeamStackSearchConfig config) {
+        configure(config);
+        Solver solver(config);
+        return solver.solve(problem);
+    });
+}
+
+template <typename Solver>
+void bench_policy(const char* name, const std::vector<proc36::Problem>& problems, double time_ms) {
+    bench_policy<Solver>(name, problems, time_ms, [](proc36::BeamStackSearchConfig&) {});
+}
+
+std::vector<proc36::Problem> random_problems(std::size_t size, std::size_t count) {
+    proc36::Random random(7);
+    std::vector<proc36::Problem> problems;
+    for (std::size_t i = 0; i < count; ++i) {
+        problems.push_back(random_problem(size, random));
+    }
+    return problems;
+}
+
+// Runs every explicitly instantiated solver on the same problems with the same time limit.
+void bench_policies(std::size_t size, double time_ms, std::size_t count) {
+    const auto problems = random_problems(size, count);
+    std::cout << "policies: " << count << " problems of size " << size << ", " << time_ms << " ms each\n";
+    std::cout << std::fixed << std::setprecision(1);
+    bench_policy<proc36::BeamStackSearchSolver>("default", problems, time_ms);
+    bench_policy<proc36::DistanceBeamSearchSolver>("distance", problems, time_ms);
+    bench_policy<proc36::ExhaustiveBeamSearchSolver>("exhaustive", problems, time_ms);
+    bench_policy<proc36::UnorderedBeamSearchSolver>("unordered", problems, time_ms);
+}
+
+// Phased (expand, then select) against pipelined (select and dedup inside the expansion tasks) parallel layers.
+void bench_pipeline(std::size_t threads, std::size_t size, double time_ms, std::size_t count) {
+    proc36::ThreadPool pool(threads);
+    const auto problems = random_problems(size, count);
+    std::cout << "pipeline: " << pool.size() << " workers, " << count << " problems of size " << size << ", "
+              << time_ms << " ms each\n";
+    std::cout << std::fixed << std::setprecision(1);
+    for (const bool pipelined : {false, true}) {
+        bench_policy<proc36::BeamStackSearchSolver>(
+            pipelined ? "pipelined" : "phased", problems, time_ms, [&](proc36::BeamStackSearchConfig& config) {
+                config.thread_pool = &pool;
+                config.pipelined_layers = pipelined;
+            });
+    }
+}
+
+// Greedy refinement from a deliberately short search, serial against the pool, with the same time budget.
+void bench_refinement(std::size_t threads, std::size_t size, double budget_ms, std::size_t count) {
+    proc36::ThreadPool pool(threads);
+    const auto problems = random_problems(size, count);
+    std::cout << "refinement: " << pool.size() << " workers, " << count << " problems of size " << size << ", "
+              << budget_ms << " ms budget\n";
+    std::cout << std::fixed << std::setprecision(1);
+    for (const bool parallel : {false, true}) {
+        bench_policy<proc36::BeamStackSearchSolver>(
+            parallel ? "pool" : "serial", problems, 0.0, [&](proc36::BeamStackSearchConfig& config) {
+                config.max_iterations = 1;
+                config.max_nodes = 1;
+                config.shake_attempts = 0;
+                config.refinement_attempts = std::numeric_limits<std::size_t>::max();
+                config.refinement_sample = std::numeric_limits<std::size_t>::max();
+                config.refinement_time_budget_ms = budget_ms;
+                config.thread_pool = parallel ? &pool : nullptr;
+            });
+    }
+}
+
+// Every generated candidate against a bandit-allocated budget of candidates per state.
+void bench_bandit(std::size_t size, double time_ms, std::size_t count, std::size_t budget) {
+    const auto problems = random_problems(size, count);
+    std::cout << "bandit: " << count << " problems of size " << size << ", " << time_ms << " ms each, budget "
+              << budget << "\n";
+    std::cout << std::fixed << std::setprecision(1);
+    for (const std::size_t candidates : {std::size_t{0}, budget}) {
+        bench_policy<proc36::BeamStackSearchSolver>(
+            candidates > 0 ? "bandit" : "all", problems, time_ms,
+            [&](proc36::BeamStackSearchConfig& config) { config.bandit_candidate_budget = candidates; });
+    }
+}
+
+// Per-child cost of keeping the one-rotation count, then solves without and with the term weighted.
+void bench_lookahead(std::size_t size, double time_ms, std::size_t count, double weight) {
+    const auto sizes = proc36::make_default_config(size).rotation_sizes;
+    const proc36::RotationReach reach(size, sizes);
+    std::cout << "lookahead: size " << size << "\n";
+    std::cout << std::fixed << std::setprecision(1);
+
+    constexpr std::size_t kParents = 160;
+    constexpr std::size_t kChildren = 64;
+    proc36::Random random(42);
+    std::vector<proc36::Field> parents;
+    for (std::size_t i = 0; i < kParents; ++i) {
+        parents.push_back(random_field(size, random));
+    }
+    std::size_t sink = 0;
+    for (const bool tracked : {false, true}) {
+        for (auto& parent : parents) {
+            parent.track_one_rotation_pairs(tracked ? &reach : nullptr);
+        }
+        proc36::Timer timer;
+        for (const auto& parent : parents) {
+            sink += expand_like(parent, kChildren);
+        }
+        std::cout << "  " << (tracked ? "tracked" : "plain") << " apply + metrics: "
+                  << timer.elapsed_ms() * 1e6 / (kParents * kChildren) << " ns/child\n";
+    }
+    if (sink == 0) {
+        std::cout << "  (no pairs matched)\n";
+    }
+
+    const auto problems = random_problems(size, count);
+    std::cout << count << " problems, " << time_ms << " ms each, weight " << weight << "\n";
+    for (const double w : {0.0, weight}) {
+        bench_policy<proc36::BeamStackSearchSolver>(
+            w != 0.0 ? "lookahead" : "default", problems, time_ms,
+            [&](proc36::BeamStackSearchConfig& config) { config.one_rotation_weight = w; });
+    }
+}
+
+// The whole board against gathering pairs into regions and solving those concurrently.
+void bench_decompose(std::size_t size, double time_ms, std::size_t count, std::size_t splits) {
+    if (splits == 0) {
+        splits = proc36::default_splits(size);
+    }
+    const auto problems = random_problems(size, count);
+    std::cout << "decompose: " << count << " problems of size " << size << ", " << time_ms << " ms each, "
+              << splits << "x" << splits << " regions\n";
+    std::cout << std::fixed << std::setprecision(1);
+    bench_policy<proc36::BeamStackSearchSolver>("whole", problems, time_ms);
+    bench_runs("regions", problems, time_ms, [&](const proc36::Problem& problem, proc36::BeamStackSearchConfig config) {
+        return proc36::solve_decomposed(problem, config, splits);
+    });
+}
+
+// The same search with and without freezing complete edge rows and columns.
+void bench_locking(std::size_t size, double time_ms, std::size_t count) {
+    const auto problems = random_problems(size, count);
+    std::cout << "locking: " << count << " problems of size " << size << ", " << time_ms << " ms each\n";
+    std::cout << std::fixed << std::setprecision(1);
+    for (const bool locking : {false, true}) {
+        bench_policy<proc36::BeamStackSearchSolver>(
+            locking ? "locked" : "free", problems, time_ms,
+            [&](proc36::BeamStackSearchConfig& config) { config.lock_completed_edges = locking; });
+    }
+}
+
+// Per-child cost of scanning the board against reading the parent's pair index, from contest sizes up to the stress
+// sizes, then whole-board solves with every window and scanned children against capped windows and indexed ones.
+void bench_scaling(double time_ms, std::size_t count, std::size_t limit) {
+    std::cout << "scaling: " << count << " problems per size, " << time_ms << " ms each, candidate limit " << limit
+              << "\n";
+    std::cout << std::fixed << std::setprecision(1);
+    proc36::Random random(42);
+    for (const std::size_t size : {12UL, 24UL, 48UL, 64UL}) {
+        constexpr std::size_t kParents = 32;
+        constexpr std::size_t kChildren = 64;
+        std::vector<proc36::Field> parents;
+        for (std::size_t i = 0; i < kParents; ++i) {
+            parents.push_back(random_field(size, random));
+        }
+        std::size_t sink = 0;
+        proc36::Timer scanned;
+        for (const auto& parent : parents) {
+            sink += expand_like(parent, kChildren);
+        }
+        const double scanned_ns = scanned.elapsed_ms() * 1e6 / (kParents * kChildren);
+
+        proc36::PairIndex::Scratch scratch;
+        proc36::Timer indexed;
+        for (const auto& parent : parents) {
+            const proc36::PairIndex index(parent);
+            for (std::size_t i = 0; i < kChildren; ++i) {
+                const auto k = 2 + i % 5;
+                const proc36::Operation op{i % (size - k + 1), (i / 7) % (size - k + 1), k};
+                const auto child = parent.applied(op);
+                sink += index.metrics_after(op, scratch).status.matched + child.cell_count();
+            }
+        }
+        const double indexed_ns = indexed.elapsed_ms() * 1e6 / (kParents * kChildren);
+        std::cout << "size " << size << ": apply + scan " << scanned_ns << " ns/child, apply + index " << indexed_ns
+                  << " ns/child" << (sink == 0 ? " (no pairs matched)" : "") << "\n";
+
+        const auto problems = random_problems(size, count);
+        for (const bool lean : {false, true}) {
+            bench_policy<proc36::BeamStackSearchSolver>(
+                lean ? "sparse" : "dense", problems, time_ms, [&](proc36::BeamStackSearchConfig& config) {
+                    config.incremental_metrics = lean;
+                    config.candidate_limit = lean ? limit : 0;
+                });
+        }
+    }
+}
+
+// Best answer so far of one solve at some moment.
+struct AnytimePoint {
+    double elapsed_ms = 0.0;
+    std::size_t operations = 0;
+    std::size_t unmatched = 0;
+    bool solved = false;
+};
+
+// One point for the start and one per change of the best answer, as seen at the layer boundaries of solve_steps (a
+// decomposed board shows only its final answer).
+std::vector<AnytimePoint> anytime_trace(const proc36::Problem& problem, const proc36::BeamStackSearchConfig& config) {
+    std::vector<AnytimePoint> trace{{0.0, 0, problem.make_field().evaluate_pairs().unmatched, false}};
+    proc36::BeamStackSearchSolver solver(config);
+    proc36::BeamStackSearchResult result;
+    proc36::Timer timer;
+    auto steps = proc36::solve_default_steps(solver, problem, {}, timer, result);
+    while (steps.next()) {
+        const auto& step = steps.value();
+        const auto& last = trace.back();
+        if (step.operations != last.operations || step.unmatched != last.unmatched || step.solved != last.solved) {
+            trace.push_back({step.elapsed_ms, step.operations, step.unmatched, step.solved});
+        }
+    }
+    return trace;
+}
+
+// The last point at or before `time_ms`.
+const AnytimePoint& point_at(const std::vector<AnytimePoint>& trace, double time_ms) {
+    auto it = std::upper_bound(trace.begin(), trace.end(), time_ms,
+                               [](double t, const AnytimePoint& point) { return t < point.elapsed_ms; });
+    return *std::prev(it);
+}
+
+// Mean over [0, time_ms] of the unmatched pairs left, as a fraction of those at the start: 0 is solved at once, 1 is
+// no progress.
+double unmatched_auc(const std::vector<AnytimePoint>& trace, double time_ms) {
+    const auto initial = static_cast<double>(std::max<std::size_t>(1, trace.front().unmatched));
+    double area = 0.0;
+    for (std::size_t i = 0; i < trace.size() && trace[i].elapsed_ms < time_ms; ++i) {
+        const auto end = i + 1 < trace.size() ? std::min(trace[i + 1].elapsed_ms, time_ms) : time_ms;
+        area += static_cast<double>(trace[i].unmatched) / initial * (end - trace[i].elapsed_ms);
+    }
+    return area / time_ms;
+}
+
+template <typename T>
+double median(std::vector<T> values) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    const auto mid = values.begin() + static_cast<std::ptrdiff_t>(values.size() / 2);
+    std::nth_element(values.begin(), mid, values.end());
+    return static_cast<double>(*mid);
+}
+
+// Every problem under every seed; per size the unmatched AUC, time to the first answer, and median curves at fixed
+// fractions of the time limit, so short budgets can be read off the same runs as the full one.
+void bench_anytime(double time_ms, std::size_t count, std::size_t seeds, const std::vector<std::size_t>& sizes) {
+    constexpr double kCheckpoints[] = {0.01, 0.02, 0.05, 0.1, 0.2, 0.5, 1.0};
+    std::cout << "anytime: " << count << " problems x " << seeds << " seeds per size, " << time_ms << " ms each\n";
+    std::cout << std::fixed << std::setprecision(1);
+    for (const auto size : sizes) {
+        const auto problems = random_problems(size, count);
+        std::vector<std::vector<AnytimePoint>> traces;
+        for (const auto& problem : problems) {
+            for (std::size_t seed = 1; seed <= seeds; ++seed) {
+                auto config = proc36::make_default_config(size);
+                config.time_limit_ms = time_ms;
+                config.seed = seed;
+                traces.push_back(anytime_trace(problem, config));
+            }
+        }
+
+        std::vector<double> aucs;
+        std::vector<double> first_solved_ms;
+        std::vector<std::size_t> final_ops;
+        for (const auto& trace : traces) {
+            aucs.push_back(unmatched_auc(trace, time_ms));
+            const auto solved = std::find_if(trace.begin(), trace.end(), [](const AnytimePoint& p) { return p.solved; });
+            if (solved != trace.end()) {
+                first_solved_ms.push_back(solved->elapsed_ms);
+                final_ops.push_back(trace.back().operations);
+            }
+        }
+        const auto mean_auc = std::accumulate(aucs.begin(), aucs.end(), 0.0) / static_cast<double>(aucs.size());
+        std::cout << "size " << size << ": solved " << first_solved_ms.size() << "/" << traces.size()
+                  << ", unmatched AUC mean " << std::setprecision(3) << mean_auc << " median " << median(aucs)
+                  << std::setprecision(1);
+        if (!first_solved_ms.empty()) {
+            std::cout << ", median first answer " << median(first_solved_ms) << " ms, median final ops "
+                      << median(final_ops);
+        }
+        std::cout << "\n  " << std::setw(9) << "ms" << std::setw(11) << "unmatched" << std::setw(8) << "ops"
+                  << std::setw(8) << "solved\n";
+        for (const double fraction : kCheckpoints) {
+            const auto t = fraction * time_ms;
+            std::vector<std::size_t> unmatched;
+            std::vector<std::size_t> ops;  // of the runs solved by then
+            for (const auto& trace : traces) {
+                const auto& point = point_at(trace, t);
+                unmatched.push_back(point.unmatched);
+                if (point.solved) {
+                    ops.push_back(point.operations);
+                }
+            }
+            std::cout << "  " << std::setw(9) << t << std::setw(11) << median(unmatched) << std::setw(8);
+            if (ops.empty()) {
+                std::cout << "-";
+            } else {
+                std::cout << median(ops);
+            }
+            std::cout << std::setw(7) << ops.size() << "\n";
+        }
+    }
+}
+
+// Per size, the same problems with and without early_rejection. Screened candidates count as explored nodes, so
+// nodes/ms compares how many candidates each run gets through.
+void bench_screening(double time_ms, std::size_t count, const std::vector<std::size_t>& sizes) {
+    std::cout << "screening: " << count << " problems per size, " << time_ms << " ms each\n";
+    std::cout << std::fixed << std::setprecision(1);
+    for (const auto size : sizes) {
+        const auto problems = random_problems(size, count);
+        std::cout << "size " << size << ":\n";
+        double plain_rate = 0.0;
+        for (const bool screening : {false, true}) {
+            std::size_t solved = 0;
+            std::size_t solved_ops = 0;
+            std::size_t unmatched = 0;
+            std::size_t nodes = 0;
+            std::size_t bound = 0;
+            std::size_t delta = 0;
+            double elapsed_ms = 0.0;
+            for (const auto& problem : problems) {
+                auto config = proc36::make_default_config(size);
+                config.time_limit_ms = time_ms;
+                config.early_rejection = screening;
+                proc36::BeamStackSearchSolver solver(config);
+                const auto result = solver.solve(problem);
+                if (result.solved) {
+                    ++solved;
+                    solved_ops += result.operations.size();
+                }
+                unmatched += result.status.unmatched;
+                nodes += result.explored_nodes;
+                bound += result.stats.bound_rejections;
+                delta += result.stats.delta_rejections;
+                elapsed_ms += result.elapsed_ms;
+            }
+            const double rate = static_cast<double>(nodes) / elapsed_ms;
+            std::cout << "  " << std::left << std::setw(12) << (screening ? "screened" : "full") << std::right
+                      << " solved " << solved << "/" << problems.size() << ", mean ops (solved) "
+                      << (solved > 0 ? static_cast<double>(solved_ops) / static_cast<double>(solved) : 0.0)
+                      << ", mean unmatched "
+                      << static_cast<double>(unmatched) / static_cast<double>(problems.size()) << ", " << rate
+                      << " nodes/ms";
+            if (screening) {
+                const auto share = [&](std::size_t part) {
+                    return nodes > 0 ? 100.0 * static_cast<double>(part) / static_cast<double>(nodes) : 0.0;
+                };
+                std::cout << ", rejected " << share(bound) << "% by bound + " << share(delta) << "% by exact delta, "
+                          << (plain_rate > 0.0 ? rate / plain_rate : 0.0) << "x";
+            }
+            std::cout << '\n';
+            plain_rate = rate;
+        }
+    }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << kUsage;
+        return EXIT_FAILURE;
+    }
+    const std::string mode = argv[1];
+    if (mode == "pool") {
+        bench_pool(argc > 2 ? static_cast<std::size_t>(std::stoul(argv[2])) : 0);
+        return EXIT_SUCCESS;
+    }
+    if (mode == "policies") {
+        bench_policies(argc > 2 ? static_cast<std::size_t>(std::stoul(argv[2])) : 8,
+                       argc > 3 ? std::stod(argv[3]) : 1000.0,
+                       argc > 4 ? static_cast<std::size_t>(std::stoul(argv[4])) : 5);
+        return EXIT_SUCCESS;
+    }
+    if (mode == "pipeline") {
+        bench_pipeline(argc > 2 ? static_cast<std::size_t>(std::stoul(argv[2])) : 0,
+                       argc > 3 ? static_cast<std::size_t>(std::stoul(argv[3])) : 16,
+                       argc > 4 ? std::stod(argv[4]) : 1000.0,
+                       argc > 5 ? static_cast<std::size_t>(std::stoul(argv[5])) : 3);
+        return EXIT_SUCCESS;
+    }
+    if (mode == "refinement") {
+        bench_refinement(argc > 2 ? static_cast<std::size_t>(std::stoul(argv[2])) : 0,
+                         argc > 3 ? static_cast<std::size_t>(std::stoul(argv[3])) : 16,
+                         argc > 4 ? std::stod(argv[4]) : 500.0,
+                         argc > 5 ? static_cast<std::size_t>(std::stoul(argv[5])) : 3);
+        return EXIT_SUCCESS;
+    }
+    if (mode == "bandit") {
+        bench_bandit(argc > 2 ? static_cast<std::size_t>(std::stoul(argv[2])) : 12,
+                     argc > 3 ? std::stod(argv[3]) : 2000.0,
+                     argc > 4 ? static_cast<std::size_t>(std::stoul(argv[4])) : 3,
+                     argc > 5 ? static_cast<std::size_t>(std::stoul(argv[5])) : 32);
+        return EXIT_SUCCESS;
+    }
+    if (mode == "decompose") {
+        bench_decompose(argc > 2 ? static_cast<std::size_t>(std::stoul(argv[2])) : 24,
+                        argc > 3 ? std::stod(argv[3]) : 4900.0,
+                        argc > 4 ? static_cast<std::size_t>(std::stoul(argv[4])) : 3,
+                        argc > 5 ? static_cast<std::size_t>(std::stoul(argv[5])) : 0);
+        return EXIT_SUCCESS;
+    }
+    if (mode == "locking") {
+        bench_locking(argc > 2 ? static_cast<std::size_t>(std::stoul(argv[2])) : 8,
+                      argc > 3 ? std::stod(argv[3]) : 1000.0,
+                      argc > 4 ? static_cast<std::size_t>(std::stoul(argv[4])) : 5);
+        return EXIT_SUCCESS;
+    }
+    if (mode == "anytime") {
+        std::vector<std::size_t> sizes;
+        for (int i = 5; i < argc; ++i) {
+            sizes.push_back(static_cast<std::size_t>(std::stoul(argv[i])));
+        }
+        if (sizes.empty()) {
+            sizes = {8, 12, 16};
+        }
+        bench_anytime(argc > 2 ? std::stod(argv[2]) : 2000.0,
+                      argc > 3 ? static_cast<std::size_t>(std::stoul(argv[3])) : 3,
+                      argc > 4 ? static_cast<std::size_t>(std::stoul(argv[4])) : 2, sizes);
+        return EXIT_SUCCESS;
+    }
+    if (mode == "screening") {
+        std::vector<std::size_t> sizes;
+        for (int i = 4; i < argc; ++i) {
+            sizes.push_back(static_cast<std::size_t>(std::stoul(argv[i])));
+        }
+        if (sizes.empty()) {
+            sizes = {8, 12, 16, 20, 24};
+        }
+        bench_screening(argc > 2 ? std::stod(argv[2]) : 2000.0,
+                        argc > 3 ? static_cast<std::size_t>(std::stoul(argv[3])) : 3, sizes);
+        return EXIT_SUCCESS;
+    }
+    if (mode == "scaling") {
+        bench_scaling(argc > 2 ? std::stod(argv[2]) : 2000.0,
+                      argc > 3 ? static_cast<std::size_t>(std::stoul(argv[3])) : 2,
+                      argc > 4 ? static_cast<std::size_t>(std::stoul(argv[4])) : 240);
+        return EXIT_SUCCESS;
+    }
+    if (mode == "lookahead") {
+        bench_lookahead(argc > 2 ? static_cast<std::size_t>(std::stoul(argv[2])) : 12,
+                        argc > 3 ? std::stod(argv[3]) : 2000.0,
+                        argc > 4 ? static_cast<std::size_t>(std::stoul(argv[4])) : 3,
+                        argc > 5 ? std::stod(argv[5]) : 2.0);
+        return EXIT_SUCCESS;
+    }
+    std::cerr << kUsage;
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,289 @@
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "lib/json.hpp"
+#include "lib/problem.hpp"
+#include "lib/random.hpp"
+#include "lib/socket.hpp"
+#include "lib/thread_pool.hpp"
+#include "lib/timer.hpp"
+#include "solver/beam_stack_search.hpp"
+#include "solver/decomposition.hpp"
+#include "solver/solve_session.hpp"
+
+namespace {
+
+constexpr const char* kUsage = "Usage: solver_daemon [--socket PATH] [--threads N]\n";
+constexpr std::size_t kMaxPrewarmedSize = 24;
+constexpr double kWarmupTimeMs = 20.0;
+
+// Serialises whole response lines to one client. Every request the client submitted shares it.
+class ResponseSink {
+public:
+    explicit ResponseSink(std::function<void(const std::string&)> write) : write_(std::move(write)) {}
+
+    void send(const std::string& line) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        try {
+            write_(line + '\n');
+        } catch (const std::exception&) {
+            // the client went away; the solve still runs to completion
+        }
+    }
+
+private:
+    std::mutex mutex_;
+    std::function<void(const std::string&)> write_;
+};
+
+// Keeps the per-size configurations and the pool alive across requests, so a request pays only for parsing
+// before its solve starts.
+class SolverDaemon {
+public:
+    explicit SolverDaemon(std::size_t threads) : pool_(threads) {
+        for (std::size_t size = 4; size <= kMaxPrewarmedSize; size += 2) {
+            configs_.emplace(size, proc36::make_default_config(size));
+        }
+        warm_up();
+    }
+
+    [[nodiscard]] std::size_t threads() const noexcept { return pool_.size(); }
+
+    void dispatch(const std::string& line, const std::shared_ptr<ResponseSink>& sink) {
+        const proc36::Timer received;
+        std::string id;
+        if (auto text = proc36::json_string_field(line, "id")) {
+            id = std::move(*text);
+        } else if (auto number = proc36::json_number_field(line, "id")) {
+            id = std::to_string(static_cast<long long>(*number));
+        }
+
+        if (proc36::json_string_field(line, "command") == "cancel") {
+            std::lock_guard<std::mutex> lock(sessions_mutex_);
+            const auto [begin, end] = sessions_.equal_range(id);
+            for (auto it = begin; it != end; ++it) {
+                it->second->cancel();
+            }
+            const auto [queued_begin, queued_end] = queued_.equal_range(id);
+            for (auto it = queued_begin; it != queued_end; ++it) {
+                cancelled_queued_.insert(it->second);
+            }
+            return;
+        }
+
+        proc36::Problem problem;
+        try {
+            problem = proc36::Problem::from_json_string(line);
+        } catch (const std::exception& e) {
+            sink->send(event_prefix(id, "error") + ",\"message\":\"" + proc36::json_escape(e.what()) + "\"}");
+            return;
+        }
+
+        auto config = config_for(problem.size);
+        if (auto limit = proc36::json_number_field(line, "time_limit_ms")) {
+            config.time_limit_ms = *limit;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(idle_mutex_);
+            ++in_flight_;
+        }
+        std::uint64_t ticket = 0;
+        {
+            std::lock_guard<std::mutex> lock(sessions_mutex_);
+            ticket = next_ticket_++;
+            queued_.emplace(id, ticket);
+        }
+        pool_.submit([this, id, ticket, sink, received, problem = std::move(problem),
+                      config = std::move(config)]() mutable {
+            solve(id, ticket, std::move(problem), std::move(config), received, *sink);
+            std::lock_guard<std::mutex> lock(idle_mutex_);
+            if (--in_flight_ == 0) {
+                idle_.notify_all();
+            }
+        });
+    }
+
+    void wait_idle() {
+        std::unique_lock<std::mutex> lock(idle_mutex_);
+        idle_.wait(lock, [this]() { return in_flight_ == 0; });
+    }
+
+private:
+    static std::string event_prefix(const std::string& id, const char* event) {
+        return "{\"id\":\"" + proc36::json_escape(id) + "\",\"event\":\"" + event + "\"";
+    }
+
+    [[nodiscard]] proc36::BeamStackSearchConfig config_for(std::size_t size) const {
+        const auto it = configs_.find(size);
+        return it != configs_.end() ? it->second : proc36::make_default_config(size);
+    }
+
+    // Takes a request off the queue; true when it was cancelled while waiting. Needs sessions_mutex_.
+    bool dequeue(const std::string& id, std::uint64_t ticket) {
+        const auto [begin, end] = queued_.equal_range(id);
+        for (auto it = begin; it != end; ++it) {
+            if (it->second == ticket) {
+                queued_.erase(it);
+                break;
+            }
+        }
+        return cancelled_queued_.erase(ticket) > 0;
+    }
+
+    void solve(const std::string& id, std::uint64_t ticket, proc36::Problem problem,
+               proc36::BeamStackSearchConfig config, const proc36::Timer& received, ResponseSink& sink) {
+        const double start_latency_us = received.elapsed_ms() * 1e3;
+        config.thread_pool = &pool_;
+        config.on_solution = [&](const std::vector<proc36::Operation>& ops) {
+            std::ostringstream oss;
+            oss << event_prefix(id, "solution") << ",\"elapsed_ms\":" << received.elapsed_ms()
+                << ",\"operations\":" << ops.size() << ",\"ops\":" << proc36::json_ops_array(ops) << '}';
+            sink.send(oss.str());
+        };
+
+        try {
+            proc36::SolveSession session(std::move(config), std::move(problem));
+            std::multimap<std::string, proc36::SolveSession*>::iterator registration;
+            {
+                std::lock_guard<std::mutex> lock(sessions_mutex_);
+                registration = sessions_.emplace(id, &session);
+                if (dequeue(id, ticket)) {
+                    session.cancel();  // it still answers, with whatever the first step finds
+                }
+            }
+            auto unregister = [&]() {
+                std::lock_guard<std::mutex> lock(sessions_mutex_);
+                sessions_.erase(registration);
+            };
+            proc36::BeamStackSearchResult result;
+            try {
+                result = session.run();
+            } catch (...) {
+                unregister();
+                throw;
+            }
+            unregister();
+            std::ostringstream oss;
+            oss << event_prefix(id, "done") << ",\"solved\":" << (result.solved ? "true" : "false")
+                << ",\"cancelled\":" << (session.cancelled() ? "true" : "false")
+                << ",\"operations\":" << result.operations.size() << ",\"unmatched\":" << result.status.unmatched
+                << ",\"explored_nodes\":" << result.explored_nodes << ",\"elapsed_ms\":" << received.elapsed_ms()
+                << ",\"start_latency_us\":" << start_latency_us
+                << ",\"ops\":" << proc36::json_ops_array(result.operations) << '}';
+            sink.send(oss.str());
+        } catch (const std::exception& e) {
+            {
+                std::lock_guard<std::mutex> lock(sessions_mutex_);
+                dequeue(id, ticket);  // in case the session never got as far as registering
+            }
+            sink.send(event_prefix(id, "error") + ",\"message\":\"" + proc36::json_escape(e.what()) + "\"}");
+        }
+    }
+
+    // One short solve per size class touches the solver code paths and grows the allocator arenas before the
+    // first real request arrives.
+    void warm_up() {
+        proc36::Random random(0x5eed);
+        for (const std::size_t size : {8UL, 16UL, 24UL}) {
+            std::vector<int> cells(size * size);
+            for (std::size_t i = 0; i < cells.size(); ++i) {
+                cells[i] = static_cast<int>(i / 2);
+            }
+            std::shuffle(cells.begin(), cells.end(), random.engine());
+            auto config = config_for(size);
+            config.time_limit_ms = kWarmupTimeMs;
+            config.thread_pool = &pool_;
+            [[maybe_unused]] const auto result = proc36::solve_default(proc36::Problem{size, std::move(cells)}, config);
+        }
+    }
+
+    std::map<std::size_t, proc36::BeamStackSearchConfig> configs_;
+    proc36::ThreadPool pool_;
+    std::mutex sessions_mutex_;
+    std::multimap<std::string, proc36::SolveSession*> sessions_;  // running solves by request id, for cancellation
+    std::multimap<std::string, std::uint64_t> queued_;             // tickets of requests waiting for a worker
+    std::set<std::uint64_t> cancelled_queued_;                     // of those, the ones already cancelled
+    std::uint64_t next_ticket_ = 0;
+    std::mutex idle_mutex_;
+    std::condition_variable idle_;
+    std::size_t in_flight_ = 0;
+};
+
+void serve_stdin(SolverDaemon& daemon) {
+    auto sink = std::make_shared<ResponseSink>([](const std::string& text) { std::cout << text << std::flush; });
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        if (line.find_first_not_of(" \t\r") == std::string::npos) {
+            continue;
+        }
+        daemon.dispatch(line, sink);
+    }
+    daemon.wait_idle();
+}
+
+void serve_socket(SolverDaemon& daemon, const std::string& path) {
+    const auto listener = proc36::Socket::listen_unix(path);
+    std::cerr << "solver_daemon listening on " << path << " with " << daemon.threads() << " workers\n";
+    while (true) {
+        auto client = std::make_shared<proc36::Socket>(listener.accept());
+        // Connection readers only block on I/O; the solves themselves run on the daemon's pool.
+        std::thread([&daemon, client]() {
+            auto sink = std::make_shared<ResponseSink>([client](const std::string& text) { client->send_all(text); });
+            std::string line;
+            try {
+                while (client->read_line(line)) {
+                    if (line.find_first_not_of(" \t") != std::string::npos) {
+                        daemon.dispatch(line, sink);
+                    }
+                }
+            } catch (const std::exception& e) {
+                std::cerr << "connection error: " << e.what() << '\n';
+            }
+        }).detach();
+    }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    try {
+        std::string socket_path;
+        std::size_t threads = 0;
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            if (arg == "--socket" && i + 1 < argc) {
+                socket_path = argv[++i];
+            } else if (arg == "--threads" && i + 1 < argc) {
+                threads = static_cast<std::size_t>(std::stoul(argv[++i]));
+            } else {
+                std::cerr << kUsage;
+                return EXIT_FAILURE;
+            }
+        }
+
+        SolverDaemon daemon(threads);
+        if (socket_path.empty()) {
+            serve_stdin(daemon);
+        } else {
+            serve_socket(daemon, socket_path);
+        }
+        return EXIT_SUCCESS;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+}
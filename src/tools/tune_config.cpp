@@ -0,0 +1,281 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "lib/problem.hpp"
+#include "lib/random.hpp"
+#include "lib/thread_pool.hpp"
+#include "lib/timer.hpp"
+#include "solver/beam_stack_search.hpp"
+#include "solver/config_table.hpp"
+
+// Races perturbations of the current settings per board size on a generated corpus. Every round runs each surviving
+// candidate on the next batch of problems (one single-threaded solve per pool worker) and drops the worse half of
+// the challengers; the incumbent always runs to the end, so the table only changes where a challenger beat it on the
+// whole corpus. Ranking: solved rate, then mean operations of the solved problems, then mean unmatched pairs.
+
+namespace {
+
+constexpr const char* kUsage =
+    "Usage: tune_config [--sizes 8,12,16,20,24] [--problems N] [--candidates N] [--time-ms MS] [--threads N]\n"
+    "                   [--seed S] [--base TABLE] [--output TABLE]\n";
+constexpr double kSpread = 0.3;  // standard deviation of the log-scale perturbations
+
+struct Options {
+    std::vector<std::size_t> sizes = {8, 12, 16, 20, 24};
+    std::size_t problems = 8;
+    std::size_t candidates = 12;
+    double time_ms = 1000.0;
+    std::size_t threads = 0;
+    std::uint64_t seed = 1;
+    std::string base_path;
+    std::string output_path = "config_table.txt";
+};
+
+struct Tally {
+    std::size_t runs = 0;
+    std::size_t solved = 0;
+    std::size_t solved_ops = 0;
+    std::size_t unmatched = 0;
+
+    [[nodiscard]] double solved_rate() const {
+        return runs > 0 ? static_cast<double>(solved) / static_cast<double>(runs) : 0.0;
+    }
+    [[nodiscard]] double mean_ops() const {
+        return solved > 0 ? static_cast<double>(solved_ops) / static_cast<double>(solved) : 0.0;
+    }
+    [[nodiscard]] double mean_unmatched() const {
+        return runs > 0 ? static_cast<double>(unmatched) / static_cast<double>(runs) : 0.0;
+    }
+};
+
+bool ranks_before(const Tally& a, const Tally& b) {
+    if (a.solved_rate() != b.solved_rate()) {
+        return a.solved_rate() > b.solved_rate();
+    }
+    if (a.solved > 0 && b.solved > 0 && a.mean_ops() != b.mean_ops()) {
+        return a.mean_ops() < b.mean_ops();
+    }
+    return a.mean_unmatched() < b.mean_unmatched();
+}
+
+struct Candidate {
+    proc36::BeamStackSearchConfig config;
+    Tally tally;
+};
+
+std::vector<std::size_t> parse_sizes(const std::string& text) {
+    std::vector<std::size_t> sizes;
+    std::istringstream iss(text);
+    std::string item;
+    while (std::getline(iss, item, ',')) {
+        sizes.push_back(static_cast<std::size_t>(std::stoul(item)));
+    }
+    return sizes;
+}
+
+bool parse_options(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            return false;
+        }
+        const std::string value = argv[++i];
+        if (arg == "--sizes") {
+            options.sizes = parse_sizes(value);
+        } else if (arg == "--problems") {
+            options.problems = static_cast<std::size_t>(std::stoul(value));
+        } else if (arg == "--candidates") {
+            options.candidates = static_cast<std::size_t>(std::stoul(value));
+        } else if (arg == "--time-ms") {
+            options.time_ms = std::stod(value);
+        } else if (arg == "--threads") {
+            options.threads = static_cast<std::size_t>(std::stoul(value));
+        } else if (arg == "--seed") {
+            options.seed = static_cast<std::uint64_t>(std::stoull(value));
+        } else if (arg == "--base") {
+            options.base_path = value;
+        } else if (arg == "--output") {
+            options.output_path = value;
+        } else {
+            return false;
+        }
+    }
+    return !options.sizes.empty() && options.problems > 0 && options.candidates > 0;
+}
+
+double perturbed(double value, proc36::Random& random) {
+    std::normal_distribution<double> noise(0.0, kSpread);
+    return value * std::exp(noise(random.engine()));
+}
+
+std::size_t perturbed(std::size_t value, std::size_t minimum, proc36::Random& random) {
+    const auto scaled = std::lround(perturbed(static_cast<double>(std::max<std::size_t>(value, 1)), random));
+    return std::max(minimum, static_cast<std::size_t>(std::max(0L, scaled)));
+}
+
+// Each knob moves with probability one half, so challengers stay near the incumbent.
+proc36::BeamStackSearchConfig mutate(const proc36::BeamStackSearchConfig& base, std::size_t board_size,
+                                     proc36::Random& random) {
+    auto config = base;
+    const auto coin = [&random]() { return random.next_int<int>(0, 1) == 1; };
+    for (double* weight : {&config.match_weight, &config.unmatched_penalty, &config.depth_penalty,
+                           &config.operation_penalty, &config.total_distance_penalty, &config.max_distance_penalty}) {
+        if (coin()) {
+            *weight = perturbed(*weight, random);
+        }
+    }
+    if (coin()) {
+        config.beam_width = perturbed(config.beam_width, 8, random);
+    }
+    if (coin()) {
+        config.max_depth = perturbed(config.max_depth, 8, random);
+    }
+    if (coin()) {
+        config.max_children_per_node = perturbed(config.max_children_per_node, 8, random);
+    }
+    if (coin()) {
+        config.refinement_sample = perturbed(config.refinement_sample, 16, random);
+    }
+    if (coin()) {
+        config.shake_attempts = random.next_int<std::size_t>(0, 8);
+        config.shake_max_length = perturbed(config.shake_max_length, 1, random);
+    }
+    if (coin()) {
+        const std::size_t budgets[] = {0, 16, 24, 32, 48, 64};
+        config.bandit_candidate_budget = budgets[random.next_int<std::size_t>(0, std::size(budgets) - 1)];
+    }
+    if (coin()) {
+        const std::size_t largest[] = {4, 5, 6, 8, 10, 12};
+        const auto top = std::min(board_size, largest[random.next_int<std::size_t>(0, std::size(largest) - 1)]);
+        config.rotation_sizes.clear();
+        for (std::size_t k = 2; k <= top; ++k) {
+            config.rotation_sizes.push_back(k);
+        }
+    }
+    return config;
+}
+
+// Runs every candidate in `alive` on problems [begin, end) concurrently and adds the outcomes to their tallies.
+void race_round(std::vector<Candidate>& candidates, const std::vector<std::size_t>& alive,
+                const std::vector<proc36::Problem>& problems, std::size_t begin, std::size_t end, double time_ms,
+                std::uint64_t seed, proc36::ThreadPool& pool) {
+    const auto batch = end - begin;
+    std::vector<proc36::BeamStackSearchResult> results(alive.size() * batch);
+    pool.parallel_for(0, results.size(), 1, [&](std::size_t task) {
+        const auto problem_index = begin + task % batch;
+        auto config = candidates[alive[task / batch]].config;
+        config.time_limit_ms = time_ms;
+        config.lns_time_budget_ms = 0.0;
+        config.thread_pool = nullptr;
+        config.seed = proc36::splitmix64(seed + problem_index);  // same jitter for every candidate on a problem
+        proc36::BeamStackSearchSolver solver(config);
+        results[task] = solver.solve(problems[problem_index]);
+    });
+    for (std::size_t task = 0; task < results.size(); ++task) {
+        auto& tally = candidates[alive[task / batch]].tally;
+        const auto& result = results[task];
+        ++tally.runs;
+        tally.unmatched += result.status.unmatched;
+        if (result.solved) {
+            ++tally.solved;
+            tally.solved_ops += result.operations.size();
+        }
+    }
+}
+
+void print_tally(const char* label, const Tally& tally) {
+    std::cout << "  " << label << ": solved " << tally.solved << "/" << tally.runs << ", mean ops (solved) "
+              << tally.mean_ops() << ", mean unmatched " << tally.mean_unmatched() << "\n";
+}
+
+proc36::BeamStackSearchConfig tune_size(std::size_t size, const proc36::BeamStackSearchConfig& base,
+                                        const Options& options, proc36::ThreadPool& pool) {
+    std::vector<proc36::Problem> problems;
+    for (std::size_t i = 0; i < options.problems; ++i) {
+        const auto seed = proc36::splitmix64(options.seed * 1'000'003ULL + size * 101 + i);
+        problems.push_back(proc36::Problem::random(size, seed));
+    }
+
+    proc36::Random random(proc36::splitmix64(options.seed ^ size));
+    std::vector<Candidate> candidates{{base, {}}};
+    for (std::size_t i = 1; i < options.candidates; ++i) {
+        candidates.push_back({mutate(base, size, random), {}});
+    }
+
+    // Halving the challengers each round needs about log2(candidates) rounds; the corpus is split evenly over them.
+    const auto rounds = static_cast<std::size_t>(std::ceil(std::log2(static_cast<double>(options.candidates)))) + 1;
+    const auto batch = std::max<std::size_t>(1, (problems.size() + rounds - 1) / rounds);
+
+    std::vector<std::size_t> alive(candidates.size());
+    for (std::size_t i = 0; i < alive.size(); ++i) {
+        alive[i] = i;
+    }
+    proc36::Timer timer;
+    for (std::size_t begin = 0; begin < problems.size(); begin += batch) {
+        const auto end = std::min(problems.size(), begin + batch);
+        race_round(candidates, alive, problems, begin, end, options.time_ms, options.seed, pool);
+
+        std::vector<std::size_t> challengers(alive.begin() + 1, alive.end());
+        std::sort(challengers.begin(), challengers.end(), [&](std::size_t a, std::size_t b) {
+            return ranks_before(candidates[a].tally, candidates[b].tally);
+        });
+        if (end < problems.size()) {
+            challengers.resize((challengers.size() + 1) / 2);
+        }
+        alive.resize(1);
+        alive.insert(alive.end(), challengers.begin(), challengers.end());
+        std::cout << "size " << size << ": " << end << "/" << problems.size() << " problems, " << alive.size()
+                  << " candidates left, " << timer.elapsed_ms() / 1000.0 << " s\n";
+    }
+
+    const auto best = *std::min_element(alive.begin(), alive.end(), [&](std::size_t a, std::size_t b) {
+        return ranks_before(candidates[a].tally, candidates[b].tally);
+    });
+    print_tally("incumbent", candidates.front().tally);
+    if (best != 0) {
+        print_tally("winner", candidates[best].tally);
+    } else {
+        std::cout << "  incumbent kept\n";
+    }
+    return candidates[best].config;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    try {
+        Options options;
+        if (!parse_options(argc, argv, options)) {
+            std::cerr << kUsage;
+            return EXIT_FAILURE;
+        }
+        const auto base = options.base_path.empty() ? proc36::ConfigTable{}
+                                                    : proc36::ConfigTable::load_from_file(options.base_path);
+        proc36::ThreadPool pool(options.threads);
+        std::cout << "tuning on " << pool.size() << " workers, " << options.problems << " problems and "
+                  << options.candidates << " candidates per size, " << options.time_ms << " ms per solve\n";
+        std::cout << std::fixed << std::setprecision(2);
+
+        proc36::ConfigTable table;
+        for (const auto size : options.sizes) {
+            auto tuned = tune_size(size, base.config_for(size), options, pool);
+            tuned.time_limit_ms = base.config_for(size).time_limit_ms;  // tuned under the race budget, not for it
+            table.set(size, tuned);
+        }
+        table.save_to_file(options.output_path);
+        std::cout << "Wrote " << options.output_path << "\n";
+        return EXIT_SUCCESS;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+}
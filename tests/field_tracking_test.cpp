@@ -0,0 +1,119 @@
+// Randomized check of what Field and PairIndex keep up to date per rotation against a full recompute: the
+// one-rotation pair count, PairIndex::metrics_after and the Zobrist hashes of the rotated boards.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "lib/field.hpp"
+#include "lib/pair_index.hpp"
+#include "lib/random.hpp"
+#include "lib/rotation_reach.hpp"
+
+namespace {
+
+constexpr std::size_t kBoards = 300;
+constexpr std::size_t kRotationsPerBoard = 20;
+constexpr std::size_t kMinSize = 4;
+constexpr std::size_t kMaxSize = 24;
+constexpr std::size_t kSizeSets = 3;  // every size, even sizes, sizes up to half the board
+
+struct RotationSet {
+    std::vector<std::size_t> sizes;
+    std::unique_ptr<proc36::RotationReach> reach;
+};
+
+std::size_t failures = 0;
+
+void expect(bool ok, const std::string& what, std::size_t board, std::size_t step) {
+    if (!ok) {
+        ++failures;
+        std::cerr << "board " << board << ", rotation " << step << ": " << what << '\n';
+    }
+}
+
+// One-rotation pairs of `field` counted from scratch by a field that has never been rotated.
+std::size_t recount_one_rotation_pairs(const proc36::Field& field, const proc36::RotationReach& reach) {
+    proc36::Field fresh(field.size(), field.cells());
+    fresh.track_one_rotation_pairs(&reach);
+    return fresh.one_rotation_pairs();
+}
+
+}  // namespace
+
+int main() {
+    proc36::Random random(0x7e57);
+    std::map<std::pair<std::size_t, std::size_t>, RotationSet> rotation_sets;  // by board size and variant
+    for (std::size_t board = 0; board < kBoards; ++board) {
+        const auto size = 2 * random.next_int<std::size_t>(kMinSize / 2, kMaxSize / 2);
+        std::vector<int> cells(size * size);
+        for (std::size_t i = 0; i < cells.size(); ++i) {
+            cells[i] = static_cast<int>(i / 2);
+        }
+        std::shuffle(cells.begin(), cells.end(), random.engine());
+
+        // Boards cycle through rotation size sets, as configs with a rotation_sizes list restrict them. The reach
+        // tables take longer to build than the checks, so each is built once.
+        const auto variant = board % kSizeSets;
+        auto& rotations = rotation_sets[{size, variant}];
+        if (!rotations.reach) {
+            for (std::size_t k = 2; k <= size; ++k) {
+                if (variant == 0 || (variant == 1 && k % 2 == 0) || (variant == 2 && 2 * k <= size)) {
+                    rotations.sizes.push_back(k);
+                }
+            }
+            rotations.reach = std::make_unique<proc36::RotationReach>(size, rotations.sizes);
+        }
+        const auto& sizes = rotations.sizes;
+        const auto& reach = *rotations.reach;
+
+        proc36::Field field(size, std::move(cells));
+        field.track_one_rotation_pairs(&reach);
+        field.track_rotated_hashes();
+        proc36::PairIndex::Scratch scratch;
+        for (std::size_t step = 0; step < kRotationsPerBoard; ++step) {
+            const auto k = sizes[random.next_int<std::size_t>(0, sizes.size() - 1)];
+            const auto x = random.next_int<std::size_t>(0, size - k);
+            const auto y = random.next_int<std::size_t>(0, size - k);
+            const proc36::Operation op{x, y, k};
+
+            const auto predicted = proc36::PairIndex(field).metrics_after(op, scratch);
+            // Half the rotations go to a copy, which must keep tracking on its own.
+            if (random.next_int<int>(0, 1) == 0) {
+                proc36::Field copy = field;
+                field = std::move(copy);
+            }
+            field.apply(op);
+
+            const auto exact = field.evaluate_pair_metrics();
+            expect(predicted.status.matched == exact.status.matched &&
+                       predicted.status.unmatched == exact.status.unmatched,
+                   "metrics_after pair counts", board, step);
+            expect(predicted.total_unmatched_distance == exact.total_unmatched_distance,
+                   "metrics_after total distance", board, step);
+            expect(predicted.max_unmatched_distance == exact.max_unmatched_distance, "metrics_after max distance",
+                   board, step);
+            expect(field.one_rotation_pairs() == recount_one_rotation_pairs(field, reach), "one_rotation_pairs",
+                   board, step);
+
+            const proc36::Field scanned(size, field.cells());
+            expect(field.zobrist_hash() == scanned.zobrist_hash(), "zobrist_hash", board, step);
+            for (std::size_t turns = 1; turns < 4; ++turns) {
+                expect(field.rotated_hash(turns) == scanned.rotated_hash(turns),
+                       "rotated_hash(" + std::to_string(turns) + ")", board, step);
+            }
+        }
+    }
+    if (failures > 0) {
+        std::cerr << failures << " mismatches\n";
+        return EXIT_FAILURE;
+    }
+    std::cout << kBoards << " boards x " << kRotationsPerBoard << " rotations match a full recompute\n";
+    return EXIT_SUCCESS;
+}